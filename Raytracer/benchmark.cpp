@@ -0,0 +1,951 @@
+//
+//  benchmark.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "benchmark.h"
+#include "primitives.h"
+#include "objloader.h"
+#include "heightfield.h"
+#include "voxeloctree.h"
+#include "spherecloud.h"
+#include "curves.h"
+#include "mesh.h"
+#include "simdmaths.h"
+#include "kernels.h"
+#include "matrixmaths.h"
+#include "fastmaths.h"
+#include "framebuffer.h"
+#include "camera.h"
+#include "pixelorder.h"
+#include <vector>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//random float in [-1, 1]
+static float randf()
+{
+    return (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+//makes rays starting on a sphere of the given radius around target, aimed roughly at target.
+static std::vector<Ray> makerays(int count, vec3 target, float radius, float spread)
+{
+    srand(1234);
+    std::vector<Ray> rays;
+    rays.reserve(count);
+    for (int i = 0; i<count; i++)
+    {
+        vec3 origin = target + vec3(randf(), randf(), randf()).normalize() * radius;
+        vec3 aim = target + vec3(randf(), randf(), randf()) * spread;
+        rays.push_back(Ray(origin, (aim - origin).normalize()));
+    }
+    return rays;
+}
+
+//finds the nearest hit for every ray, returning the number of rays that hit something.
+static int tracenearest(const std::vector<Primitive*>& prims, const std::vector<Ray>& rays)
+{
+    int hits = 0;
+    for (const Ray& ray : rays)
+    {
+        float nearest = FLT_MAX, intersection;
+        uint64_t element;
+        for (Primitive* p : prims)
+        {
+            if (p->Raycast(ray, intersection, element) && intersection < nearest)
+                nearest = intersection;
+        }
+        if (nearest < FLT_MAX)
+            hits++;
+    }
+    return hits;
+}
+
+//times tracing the rays against prims several times over and prints the throughput.
+static void timetrace(const char* name, const std::vector<Primitive*>& prims, const std::vector<Ray>& rays, int repeats)
+{
+    clock_t start = clock();
+    int hits = 0;
+    for (int i = 0; i<repeats; i++)
+        hits += tracenearest(prims, rays);
+    double seconds = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    printf("  %-24s %6d prims %8.3f Mrays/s (%d hits)\n", name, (int)prims.size(), (rays.size() * repeats) / (seconds * 1000000.0), hits / repeats);
+}
+
+static void deleteall(std::vector<Primitive*>& prims)
+{
+    for (Primitive* p : prims)
+        delete p;
+    prims.clear();
+}
+
+//native box against the twelve triangles of cube.obj
+static void benchmarkbox()
+{
+    std::vector<vec3> verts, normals;
+    std::vector<vec2> uvs;
+    std::vector<int> inds;
+    LoadModel("cube.obj", verts, uvs, normals, inds);
+    if (verts.empty())
+    {
+        printf("  could not load cube.obj, run from the Raytracer directory\n");
+        return;
+    }
+    
+    std::vector<Primitive*> triangles;
+    vec3 min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (size_t i = 0; i<inds.size(); i+=3)
+        triangles.push_back(new Triangle(verts[inds[i]], verts[inds[i+1]], verts[inds[i+2]]));
+    for (const vec3& v : verts)
+    {
+        min = min.min(v);
+        max = max.max(v);
+    }
+    
+    std::vector<Primitive*> box;
+    box.push_back(new Box(min, max));
+    
+    std::vector<Ray> rays = makerays(1000000, (min + max) * 0.5f, 4.0f, 1.0f);
+    timetrace("triangulated cube.obj", triangles, rays, 4);
+    timetrace("box", box, rays, 4);
+    
+    deleteall(triangles);
+    deleteall(box);
+}
+
+//builds both a native quad and a split triangle version of the given quads.
+static void makequads(const std::vector<vec3>& verts, const std::vector<int>& quadInds, std::vector<Primitive*>& quads, std::vector<Primitive*>& triangles)
+{
+    for (size_t i = 0; i<quadInds.size(); i+=4)
+    {
+        const vec3 &a = verts[quadInds[i]], &b = verts[quadInds[i+1]], &c = verts[quadInds[i+2]], &d = verts[quadInds[i+3]];
+        triangles.push_back(new Triangle(a, b, c));
+        triangles.push_back(new Triangle(a, c, d));
+        if (Quad::CanRepresent(a, b, c, d))
+            quads.push_back(new Quad(a, b, c, d));
+        else
+        {
+            quads.push_back(new Triangle(a, b, c));
+            quads.push_back(new Triangle(a, c, d));
+        }
+    }
+}
+
+//native quads against the same faces split into triangles, for cube.obj and a quad torus
+static void benchmarkquad()
+{
+    std::vector<vec3> verts, normals;
+    std::vector<vec2> uvs;
+    std::vector<int> inds, quadInds;
+    std::vector<Primitive*> quads, triangles;
+    
+    LoadModel("cube.obj", verts, uvs, normals, inds, quadInds);
+    if (verts.empty())
+        printf("  could not load cube.obj, run from the Raytracer directory\n");
+    else
+    {
+        makequads(verts, quadInds, quads, triangles);
+        std::vector<Ray> rays = makerays(1000000, vec3(0.0f, 0.5f, 0.0f), 4.0f, 1.0f);
+        timetrace("cube.obj triangles", triangles, rays, 2);
+        timetrace("cube.obj quads", quads, rays, 2);
+        deleteall(quads);
+        deleteall(triangles);
+    }
+    
+    //a torus is built entirely from planar trapezoids
+    const int rings = 64, sides = 32;
+    const float R = 2.0f, r = 0.75f;
+    verts.clear();
+    quadInds.clear();
+    for (int i = 0; i<rings; i++)
+    {
+        float u = i * 2.0f * M_PI / rings;
+        for (int j = 0; j<sides; j++)
+        {
+            float v = j * 2.0f * M_PI / sides;
+            verts.push_back(vec3((R + r*cosf(v)) * cosf(u), r*sinf(v), (R + r*cosf(v)) * sinf(u)));
+            
+            int i1 = (i+1) % rings, j1 = (j+1) % sides;
+            quadInds.push_back(i*sides + j);
+            quadInds.push_back(i*sides + j1);
+            quadInds.push_back(i1*sides + j1);
+            quadInds.push_back(i1*sides + j);
+        }
+    }
+    makequads(verts, quadInds, quads, triangles);
+    std::vector<Ray> rays = makerays(50000, vec3(), 6.0f, 2.5f);
+    timetrace("torus triangles", triangles, rays, 1);
+    timetrace("torus quads", quads, rays, 1);
+    deleteall(quads);
+    deleteall(triangles);
+}
+
+//a 4096 x 4096 rolling terrain seen from above at a shallow angle
+static void benchmarkheightfield()
+{
+    const int size = 4096;
+    const float cellSize = 0.01f;
+    std::vector<float> heights((size_t)size * size);
+    for (int z = 0; z<size; z++)
+        for (int x = 0; x<size; x++)
+            heights[(size_t)z * size + x] = sinf(x * 0.013f) * cosf(z * 0.007f) * 2.0f + sinf((x + z) * 0.11f) * 0.1f;
+    
+    std::vector<Primitive*> terrain;
+    Heightfield* field = new Heightfield(vec3(), cellSize, size, size, heights);
+    terrain.push_back(field);
+    
+    //the same surface as individual triangles would need two per cell plus a pointer each
+    size_t triangleBytes = (size_t)(size - 1) * (size - 1) * 2 * (sizeof(Triangle) + sizeof(Primitive*));
+    printf("  %d x %d samples: %.1f MB (%.2f bytes per sample), as triangles %.1f MB\n", size, size,
+           field->MemoryUsage() / (1024.0 * 1024.0), field->MemoryUsage() / (double)heights.size(), triangleBytes / (1024.0 * 1024.0));
+    
+    srand(1234);
+    std::vector<Ray> rays;
+    vec3 eye(size * cellSize * 0.5f, 6.0f, -5.0f);
+    for (int i = 0; i<200000; i++)
+    {
+        vec3 aim(size * cellSize * (randf() * 0.5f + 0.5f), 0.0f, size * cellSize * (randf() * 0.5f + 0.5f));
+        rays.push_back(Ray(eye, (aim - eye).normalize()));
+    }
+    timetrace("heightfield", terrain, rays, 1);
+    deleteall(terrain);
+}
+
+//a 1024^3 volume holding a two voxel thick sphere shell, loaded back from a voxel file
+static void benchmarkvoxels()
+{
+    const int resolution = 1024;
+    const float radius = 500.0f, center = resolution * 0.5f;
+    std::vector<Voxel> voxels;
+    for (int y = 0; y<resolution; y++)
+    {
+        for (int x = 0; x<resolution; x++)
+        {
+            float dx = x + 0.5f - center, dy = y + 0.5f - center, r2 = dx*dx + dy*dy;
+            for (float r : { radius - 1.0f, radius + 1.0f })
+            {
+                if (r2 > r*r)
+                    continue;
+                float dz = sqrtf(r*r - r2);
+                voxels.push_back({ (uint16_t)x, (uint16_t)y, (uint16_t)(center + dz) });
+                voxels.push_back({ (uint16_t)x, (uint16_t)y, (uint16_t)(center - dz) });
+            }
+        }
+    }
+    
+    const char* file = "/tmp/raytracer_benchmark.svox";
+    if (!VoxelOctree::Save(file, resolution, voxels))
+    {
+        printf("  could not write %s\n", file);
+        return;
+    }
+    VoxelOctree* octree = VoxelOctree::Load(file, vec3(-1.0f, -1.0f, -1.0f), 2.0f / resolution);
+    remove(file);
+    
+    std::vector<Primitive*> prims;
+    prims.push_back(octree);
+    printf("  %d^3 grid, %d voxels: %zu nodes, %.1f MB\n", resolution, (int)voxels.size(), octree->NodeCount(), octree->MemoryUsage() / (1024.0 * 1024.0));
+    
+    std::vector<Ray> rays = makerays(200000, vec3(), 3.0f, 1.0f);
+    timetrace("voxel octree", prims, rays, 1);
+    deleteall(prims);
+}
+
+//ten million spheres with a shared radius spread through a cube
+static void benchmarkspherecloud()
+{
+    const int count = 10000000;
+    srand(1234);
+    std::vector<vec3> centers;
+    centers.reserve(count);
+    for (int i = 0; i<count; i++)
+        centers.push_back(vec3(randf(), randf(), randf()) * 10.0f);
+    
+    clock_t start = clock();
+    SphereCloud* cloud = new SphereCloud(centers, 0.01f);
+    double buildSeconds = (clock() - start) / (double)CLOCKS_PER_SEC;
+    std::vector<vec3>().swap(centers);
+    
+    std::vector<Primitive*> prims;
+    prims.push_back(cloud);
+    printf("  %d spheres: %.1f MB, built in %.2f seconds\n", (int)cloud->SphereCount(), cloud->MemoryUsage() / (1024.0 * 1024.0), buildSeconds);
+    
+    std::vector<Ray> rays = makerays(200000, vec3(), 20.0f, 10.0f);
+    timetrace("sphere cloud", prims, rays, 1);
+    deleteall(prims);
+}
+
+//a million leaning grass blades on a 20 x 20 patch, seen from above at an angle
+static void benchmarkcurves()
+{
+    const int count = 1000000;
+    srand(1234);
+    std::vector<CurveSegment> segments;
+    segments.reserve(count);
+    for (int i = 0; i<count; i++)
+    {
+        vec3 base(randf() * 10.0f, 0.0f, randf() * 10.0f);
+        vec3 lean(randf() * 0.2f, 0.0f, randf() * 0.2f);
+        float height = 0.3f + randf() * 0.1f;
+        CurveSegment s = {
+            base,
+            base + vec3(0.0f, height / 3.0f, 0.0f),
+            base + vec3(0.0f, height * 2.0f / 3.0f, 0.0f) + lean * 0.5f,
+            base + vec3(0.0f, height, 0.0f) + lean,
+            0.01f, 0.002f
+        };
+        segments.push_back(s);
+    }
+    
+    Curves* curves = new Curves(segments);
+    std::vector<CurveSegment>().swap(segments);
+    
+    //tessellated for LoadModel each blade would be at least eight quads, sixteen Triangles
+    float aligned, oriented;
+    curves->BoundsVolume(aligned, oriented);
+    size_t triangleBytes = (size_t)count * 16 * (sizeof(Triangle) + sizeof(Primitive*));
+    printf("  %d strands: %.1f MB, as triangles %.1f MB, oriented boxes %.1f%% of the axis aligned volume\n", count,
+           curves->MemoryUsage() / (1024.0 * 1024.0), triangleBytes / (1024.0 * 1024.0), oriented / aligned * 100.0f);
+    
+    std::vector<Primitive*> prims;
+    prims.push_back(curves);
+    std::vector<Ray> rays;
+    vec3 eye(0.0f, 8.0f, -14.0f);
+    for (int i = 0; i<200000; i++)
+    {
+        vec3 aim(randf() * 10.0f, 0.0f, randf() * 10.0f);
+        rays.push_back(Ray(eye, (aim - eye).normalize()));
+    }
+    timetrace("curves", prims, rays, 1);
+    deleteall(prims);
+}
+
+//a million slightly bent strands pointing every which way through a 10 x 10 x 10 cube, where the
+//axis aligned boxes of the diagonal ones are far bigger than the strands
+static void benchmarkhaircurves()
+{
+    const int count = 1000000;
+    srand(1234);
+    std::vector<CurveSegment> segments;
+    segments.reserve(count);
+    for (int i = 0; i<count; i++)
+    {
+        vec3 base = vec3(randf(), randf(), randf()) * 5.0f;
+        vec3 dir = vec3(randf(), randf(), randf()).normalize(), bend = vec3(randf(), randf(), randf()) * 0.03f;
+        float length = 0.4f + randf() * 0.1f;
+        CurveSegment s = {
+            base,
+            base + dir * (length / 3.0f) + bend,
+            base + dir * (length * 2.0f / 3.0f) + bend,
+            base + dir * length,
+            0.004f, 0.002f
+        };
+        segments.push_back(s);
+    }
+    
+    Curves* curves = new Curves(segments);
+    std::vector<CurveSegment>().swap(segments);
+    
+    float aligned, oriented;
+    curves->BoundsVolume(aligned, oriented);
+    printf("  %d strands in %zu pieces: %.1f MB, oriented boxes %.1f%% of the axis aligned volume\n", count,
+           curves->PieceCount(), curves->MemoryUsage() / (1024.0 * 1024.0), oriented / aligned * 100.0f);
+    
+    std::vector<Primitive*> prims;
+    prims.push_back(curves);
+    std::vector<Ray> rays = makerays(200000, vec3(), 12.0f, 5.0f);
+    timetrace("hair curves", prims, rays, 1);
+    deleteall(prims);
+}
+
+//a million triangle bumpy torus, as a plain indexed mesh and compressed into clusters
+static void benchmarkclustermesh()
+{
+    const int rings = 1024, sides = 512;
+    const float R = 2.0f, r = 0.75f;
+    std::vector<vec3> verts;
+    std::vector<int> inds;
+    for (int i = 0; i<rings; i++)
+    {
+        float u = i * 2.0f * M_PI / rings;
+        for (int j = 0; j<sides; j++)
+        {
+            float v = j * 2.0f * M_PI / sides;
+            float bumpy = r + sinf(u * 24.0f) * sinf(v * 12.0f) * 0.05f;
+            verts.push_back(vec3((R + bumpy*cosf(v)) * cosf(u), bumpy*sinf(v), (R + bumpy*cosf(v)) * sinf(u)));
+            
+            int i1 = (i+1) % rings, j1 = (j+1) % sides;
+            int quad[4] = { i*sides + j, i*sides + j1, i1*sides + j1, i1*sides + j };
+            for (int k : { 0, 1, 2, 0, 2, 3 })
+                inds.push_back(quad[k]);
+        }
+    }
+    
+    Mesh* mesh = new Mesh(verts, inds);
+    ClusterMesh* clustered = new ClusterMesh(verts, inds);
+    size_t triangleCount = inds.size() / 3;
+    size_t triangleBytes = triangleCount * (sizeof(Triangle) + sizeof(Primitive*));
+    printf("  %d triangles: as Triangles %.1f MB, indexed mesh %.1f MB, %zu clusters %.1f MB (%.2f bytes per triangle)\n", (int)triangleCount,
+           triangleBytes / (1024.0 * 1024.0), mesh->MemoryUsage() / (1024.0 * 1024.0), clustered->ClusterCount(),
+           clustered->MemoryUsage() / (1024.0 * 1024.0), clustered->MemoryUsage() / (double)triangleCount);
+    
+    std::vector<Primitive*> plain, compressed;
+    plain.push_back(mesh);
+    compressed.push_back(clustered);
+    std::vector<Ray> rays = makerays(500000, vec3(), 6.0f, 2.5f);
+    timetrace("indexed mesh", plain, rays, 1);
+    timetrace("cluster mesh", compressed, rays, 1);
+    deleteall(plain);
+    deleteall(compressed);
+}
+
+//times repeats calls of op, each working through count vectors, and prints the throughput.
+//op returns a value that depends on its results so the work can't be optimised away.
+template<typename Op>
+static void timeops(const char* name, int count, int repeats, Op op)
+{
+    clock_t start = clock();
+    float sink = 0.0f;
+    for (int i = 0; i<repeats; i++)
+        sink += op();
+    double seconds = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    printf("  %-24s %8.1f Mops/s (%g)\n", name, (double)count * repeats / (seconds * 1000000.0), sink);
+}
+
+//dot, cross and normalize throughput of the scalar vec3 against the SSE vec3a
+static void benchmarkvecmath()
+{
+    const int count = 4096, repeats = 20000;
+    srand(1234);
+    std::vector<vec3> a, b, out(count);
+    std::vector<vec3a> aa, ba, outa(count);
+    std::vector<float> dots(count);
+    for (int i = 0; i<count; i++)
+    {
+        a.push_back(vec3(randf(), randf(), randf()));
+        b.push_back(vec3(randf(), randf(), randf()));
+        aa.push_back(vec3a(a.back()));
+        ba.push_back(vec3a(b.back()));
+    }
+    
+    timeops("vec3 dot", count, repeats, [&]() { for (int i = 0; i<count; i++) dots[i] = a[i].dot(b[i]); return dots[count/2]; });
+    timeops("vec3a dot", count, repeats, [&]() { for (int i = 0; i<count; i++) dots[i] = aa[i].dot(ba[i]); return dots[count/2]; });
+    timeops("vec3 cross", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = a[i].cross(b[i]); return out[count/2].x; });
+    timeops("vec3a cross", count, repeats, [&]() { for (int i = 0; i<count; i++) outa[i] = aa[i].cross(ba[i]); return outa[count/2].x; });
+    timeops("vec3 normalize", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = a[i].normalize(); return out[count/2].x; });
+    timeops("vec3a normalize", count, repeats, [&]() { for (int i = 0; i<count; i++) outa[i] = aa[i].normalize(); return outa[count/2].x; });
+}
+
+//the exact maths the shading uses against the fastmaths.h approximations
+static void benchmarkfastmath()
+{
+    const int count = 4096, repeats = 20000;
+    srand(1234);
+    std::vector<vec3> a(count), out(count);
+    std::vector<float> x(count), results(count);
+    for (int i = 0; i<count; i++)
+    {
+        a[i] = vec3(randf(), randf(), randf());
+        x[i] = randf() * 0.5f + 0.5f;
+    }
+    
+    timeops("vec3 normalize", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = a[i].normalize(); return out[count/2].x; });
+    timeops("fastnormalize", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = fastnormalize(a[i]); return out[count/2].x; });
+    timeops("powf x^20", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = powf(x[i], 20.0f); return results[count/2]; });
+    timeops("powi x^20", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = powi<20>(x[i]); return results[count/2]; });
+    timeops("expf", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = expf(x[i]); return results[count/2]; });
+    timeops("fastexp", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = fastexp(x[i]); return results[count/2]; });
+    timeops("logf", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = logf(x[i]); return results[count/2]; });
+    timeops("fastlog", count, repeats, [&]() { for (int i = 0; i<count; i++) results[i] = fastlog(x[i]); return results[count/2]; });
+}
+
+//converting a frame of radiance to pixels, against clamping and sRGB encoding each channel with powf
+static void benchmarkframebuffer()
+{
+    const int width = 800, height = 600, count = width * height, repeats = 100;
+    srand(1234);
+    std::vector<vec3> radiance(count);
+    for (vec3& c : radiance)
+        c = vec3(randf(), randf(), randf()) * 0.75f + vec3(0.5f, 0.5f, 0.5f);
+    std::vector<unsigned char> pixels(count * 4);
+    
+    timeops("scalar sRGB", count, repeats, [&]() {
+        const float* values = &radiance[0].x;
+        for (int i = 0; i<count * 3; i++)
+        {
+            float c = values[i] < 0.0f ? 0.0f : (values[i] > 1.0f ? 1.0f : values[i]);
+            c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            pixels[i] = (unsigned char)(c * 255.0f + 0.5f);
+        }
+        return (float)pixels[count/2];
+    });
+    
+    PixelFormat format;
+    timeops("convert sRGB", count, repeats, [&]() { convertpixels(radiance.data(), width, height, format, pixels.data()); return (float)pixels[count/2]; });
+    format.srgb = false;
+    timeops("convert linear", count, repeats, [&]() { convertpixels(radiance.data(), width, height, format, pixels.data()); return (float)pixels[count/2]; });
+    format.srgb = true;
+    format.dither = true;
+    timeops("convert sRGB dithered", count, repeats, [&]() { convertpixels(radiance.data(), width, height, format, pixels.data()); return (float)pixels[count/2]; });
+    format.layout = PixelRGBA8;
+    timeops("convert sRGB RGBA8", count, repeats, [&]() { convertpixels(radiance.data(), width, height, format, pixels.data()); return (float)pixels[count/2]; });
+}
+
+//primary rays for a frame, built and normalized one at a time against the Camera's rows of packets
+static void benchmarkcamera()
+{
+    const int width = 800, height = 600, repeats = 50;
+    Camera camera(vec3(0.0f, 0.0f, -5.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 1.0f, width, height);
+    std::vector<Ray> rays(width * height);
+    
+    timeops("single rays", width * height, repeats, [&]() {
+        for (int y = 0; y<height; y++)
+            for (int x = 0; x<width; x++)
+                rays[y * width + x] = Ray(camera.position, (vec3(x * 0.01f - 4.0f, y * 0.01f - 4.0f, 0.0f) - camera.position).normalize());
+        return rays[width * height / 2].direction.x;
+    });
+    timeops("GetRay", width * height, repeats, [&]() {
+        for (int y = 0; y<height; y++)
+            for (int x = 0; x<width; x++)
+                rays[y * width + x] = camera.GetRay(x, y);
+        return rays[width * height / 2].direction.x;
+    });
+    timeops("GetRays", width * height, repeats, [&]() {
+        for (int y = 0; y<height; y++)
+            camera.GetRays(0, y, width, &rays[y * width]);
+        return rays[width * height / 2].direction.x;
+    });
+    
+    float sink = 0.0f;
+    timeops("GetPacket", width * height, repeats, [&]() {
+        for (int y = 0; y<height; y++)
+            for (int x = 0; x<width; x+=8)
+                sink += camera.GetPacket(x, y, 8).direction.x[0];
+        return sink;
+    });
+}
+
+//mat4 multiply and inverse throughput, and transforming vertices one at a time against in batches.
+//The vertices fit in cache, a million vertices is bound by memory bandwidth either way.
+static void benchmarkmatrix()
+{
+    const int count = 4096, repeats = 500, vertexCount = 1 << 12;
+    srand(1234);
+    std::vector<mat4> a(count), b(count), out(count);
+    for (int i = 0; i<count; i++)
+    {
+        a[i] = mat4::axisangle(vec3(randf(), randf(), randf()).normalize(), randf()) * mat4::translate(randf(), randf(), randf());
+        b[i] = mat4::axisangle(vec3(randf(), randf(), randf()).normalize(), randf());
+    }
+    std::vector<vec3> verts(vertexCount), outVerts(vertexCount);
+    for (vec3& v : verts)
+        v = vec3(randf(), randf(), randf());
+    
+    timeops("mat4 *", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = a[i] * b[i]; return out[count/2].rows[0]; });
+    timeops("multiply", count, repeats, [&]() { for (int i = 0; i<count; i++) out[i] = multiply(a[i], b[i]); return out[count/2].rows[0]; });
+    timeops("inverse", count, repeats, [&]() { for (int i = 0; i<count; i++) inverse(a[i], out[i]); return out[count/2].rows[0]; });
+    timeops("affineInverse", count, repeats, [&]() { for (int i = 0; i<count; i++) affineInverse(a[i], out[i]); return out[count/2].rows[0]; });
+    timeops("transformPoint", vertexCount, 5000, [&]() { for (int i = 0; i<vertexCount; i++) outVerts[i] = transformPoint(a[0], verts[i]); return outVerts[vertexCount/2].x; });
+    timeops("transformPoints", vertexCount, 5000, [&]() { transformPoints(a[0], verts.data(), outVerts.data(), vertexCount); return outVerts[vertexCount/2].x; });
+    timeops("transformDirections", vertexCount, 5000, [&]() { transformDirections(a[0], verts.data(), outVerts.data(), vertexCount); return outVerts[vertexCount/2].x; });
+}
+
+//times single rays against the packet kernel of prim, checking both find the same hits.
+//The packets are loaded from lanes, structure of arrays ray data, as std::vector can't hold AVX types.
+template<typename Prim>
+static void timepacket(const char* name, Prim& prim, const std::vector<Ray>& rays, const std::vector<float>& lanes, int repeats)
+{
+    clock_t start = clock();
+    int hits = 0;
+    for (int r = 0; r<repeats; r++)
+    {
+        for (const Ray& ray : rays)
+        {
+            float intersection;
+            uint64_t element;
+            if (prim.Raycast(ray, intersection, element))
+                hits++;
+        }
+    }
+    double single = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    start = clock();
+    int packetHits = 0;
+    for (int r = 0; r<repeats; r++)
+    {
+        for (size_t i = 0; i<lanes.size(); i+=48)
+        {
+            const float* p = &lanes[i];
+            RayPacket packet(vec3x8(floatx8::load(p), floatx8::load(p + 8), floatx8::load(p + 16)),
+                             vec3x8(floatx8::load(p + 24), floatx8::load(p + 32), floatx8::load(p + 40)));
+            floatx8 intersection;
+            uint64_t elements[8];
+            packetHits += __builtin_popcount(prim.RaycastPacket(packet, intersection, elements).bits());
+        }
+    }
+    double packet = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    double mrays = rays.size() * (double)repeats / 1000000.0;
+    printf("  %-10s single %8.1f Mrays/s, packet %8.1f Mrays/s (%d / %d hits)\n", name, mrays / single, mrays / packet, hits / repeats, packetHits / repeats);
+}
+
+//sphere, plane and triangle tested eight rays at a time with vec3x8 against one ray at a time
+static void benchmarkpacket()
+{
+    std::vector<Ray> rays = makerays(1 << 20, vec3(), 4.0f, 1.5f);
+    std::vector<float> lanes(rays.size() * 6);
+    for (size_t i = 0; i<rays.size(); i++)
+    {
+        //each packet is eight origin x, then y, z, and the same for direction
+        float* p = &lanes[(i / 8) * 48 + i % 8];
+        const Ray& ray = rays[i];
+        p[0] = ray.origin.x; p[8] = ray.origin.y; p[16] = ray.origin.z;
+        p[24] = ray.direction.x; p[32] = ray.direction.y; p[40] = ray.direction.z;
+    }
+    
+    Sphere sphere(vec3(0.2f, 0.1f, 0.0f), 1.0f);
+    Plane plane(vec3(0.0f, 1.0f, 0.0f), -0.5f);
+    Triangle triangle(vec3(-1.0f, -1.0f, 0.5f), vec3(1.0f, -1.0f, 0.0f), vec3(0.0f, 1.0f, -0.5f));
+    timepacket("sphere", sphere, rays, lanes, 20);
+    timepacket("plane", plane, rays, lanes, 20);
+    timepacket("triangle", triangle, rays, lanes, 20);
+}
+
+//a pinhole camera at eye looking down +z for the primary visibility benchmark
+static Ray primaryray(const vec3& eye, int x, int y, int size)
+{
+    vec3 target(x * 2.0f / size - 1.0f, y * 2.0f / size - 1.0f, 1.0f);
+    return Ray(eye, target.normalize());
+}
+
+//nearest hit of the primary rays of every pixel one at a time, returning the number of pixels hit.
+static int primarysingle(const std::vector<Primitive*>& prims, const vec3& eye, int size)
+{
+    int hits = 0;
+    for (int y = 0; y<size; y++)
+    {
+        for (int x = 0; x<size; x++)
+        {
+            Ray ray = primaryray(eye, x, y, size);
+            float nearest = FLT_MAX, intersection;
+            uint64_t element;
+            for (Primitive* p : prims)
+            {
+                if (p->Raycast(ray, intersection, element) && intersection < nearest)
+                    nearest = intersection;
+            }
+            if (nearest < FLT_MAX)
+                hits++;
+        }
+    }
+    return hits;
+}
+
+//the same as 8 x 8 tiles, culling primitives against each tile's frustum and tracing rows as packets.
+static int primarypacket(const std::vector<Primitive*>& prims, const vec3& eye, int size)
+{
+    int hits = 0;
+    std::vector<Primitive*> visible;
+    for (int tileY = 0; tileY<size; tileY+=8)
+    {
+        for (int tileX = 0; tileX<size; tileX+=8)
+        {
+            vec3 corners[4] = { primaryray(eye, tileX, tileY, size).direction, primaryray(eye, tileX + 7, tileY, size).direction,
+                                primaryray(eye, tileX + 7, tileY + 7, size).direction, primaryray(eye, tileX, tileY + 7, size).direction };
+            Frustum frustum(eye, corners);
+            visible.clear();
+            for (Primitive* p : prims)
+            {
+                AABB bounds;
+                if (!p->GetBounds(bounds) || frustum.Overlaps(bounds))
+                    visible.push_back(p);
+            }
+            
+            for (int y = tileY; y<tileY + 8; y++)
+            {
+                Ray rays[8];
+                for (int i = 0; i<8; i++)
+                    rays[i] = primaryray(eye, tileX + i, y, size);
+                RayPacket packet(rays);
+                floatx8 nearest(FLT_MAX), intersection;
+                uint64_t elements[8];
+                for (Primitive* p : visible)
+                {
+                    maskx8 hit = p->RaycastPacket(packet, intersection, elements);
+                    maskx8 closer = hit & (intersection < nearest);
+                    nearest = floatx8::select(closer, intersection, nearest);
+                }
+                hits += __builtin_popcount((nearest < FLT_MAX).bits());
+            }
+        }
+    }
+    return hits;
+}
+
+static void timeprimary(const char* name, const std::vector<Primitive*>& prims, const vec3& eye, int size)
+{
+    clock_t start = clock();
+    int hits = primarysingle(prims, eye, size);
+    double single = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    start = clock();
+    int packetHits = primarypacket(prims, eye, size);
+    double packet = (clock() - start) / (double)CLOCKS_PER_SEC;
+    
+    double mrays = size * size / 1000000.0;
+    printf("  %-20s single %7.2f Mrays/s, packet %7.2f Mrays/s (%d / %d hits)\n", name, mrays / single, mrays / packet, hits, packetHits);
+}
+
+//the million triangle torus around the z axis, two across and one and a half thick
+static void maketorus(std::vector<vec3>& verts, std::vector<int>& inds)
+{
+    const int rings = 1024, sides = 512;
+    for (int i = 0; i<rings; i++)
+    {
+        float u = i * 2.0f * M_PI / rings;
+        for (int j = 0; j<sides; j++)
+        {
+            float v = j * 2.0f * M_PI / sides;
+            verts.push_back(vec3((2.0f + 0.75f*cosf(v)) * cosf(u), (2.0f + 0.75f*cosf(v)) * sinf(u), 0.75f*sinf(v)));
+            int i1 = (i+1) % rings, j1 = (j+1) % sides;
+            int quad[4] = { i*sides + j, i*sides + j1, i1*sides + j1, i1*sides + j };
+            for (int k : { 0, 1, 2, 0, 2, 3 })
+                inds.push_back(quad[k]);
+        }
+    }
+}
+
+//primary visibility of 8 x 8 pixel tiles traced as packets against tracing pixels one at a time
+static void benchmarkprimary()
+{
+    //a field of spheres over a plane, where the frustum test leaves each tile a handful of spheres
+    std::vector<Primitive*> spheres;
+    for (int z = 0; z<32; z++)
+        for (int x = 0; x<32; x++)
+            spheres.push_back(new Sphere(vec3(x - 15.5f, (x * 7 + z * 3) % 5 * 0.2f - 1.0f, z + 2.0f), 0.4f));
+    spheres.push_back(new Plane(vec3(0.0f, 1.0f, 0.0f), -1.5f));
+    timeprimary("1024 spheres, plane", spheres, vec3(0.0f, 1.0f, -4.0f), 512);
+    deleteall(spheres);
+    
+    //the million triangle torus, where the packet walks the mesh hierarchy together
+    std::vector<vec3> verts;
+    std::vector<int> inds;
+    maketorus(verts, inds);
+    std::vector<Primitive*> mesh;
+    mesh.push_back(new Mesh(verts, inds));
+    timeprimary("1M triangle mesh", mesh, vec3(0.0f, 0.0f, -4.0f), 512);
+    deleteall(mesh);
+}
+
+//counts the L1 data and last level cache read misses of the calling thread between Start and Stop,
+//through perf events on Linux. L2 misses aren't counted, there's no generic event for them. The L1
+//misses are only what reaches L2, not what misses in it. Elsewhere, or where the kernel doesn't give
+//out the counters, Available is false.
+struct CacheCounters
+{
+    uint64_t l1Misses, llMisses;
+
+    CacheCounters() : l1Misses(0), llMisses(0)
+    {
+        fds[0] = OpenCounter(PERF_COUNT_HW_CACHE_L1D);
+        fds[1] = OpenCounter(PERF_COUNT_HW_CACHE_LL);
+    }
+
+    ~CacheCounters()
+    {
+#if defined(__linux__)
+        for (int fd : fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    bool Available() const
+    {
+        return fds[0] >= 0 && fds[1] >= 0;
+    }
+
+    void Start()
+    {
+#if defined(__linux__)
+        for (int fd : fds)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void Stop()
+    {
+#if defined(__linux__)
+        uint64_t* counts[2] = { &l1Misses, &llMisses };
+        for (int i = 0; i<2; i++)
+        {
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], counts[i], sizeof(uint64_t)) != sizeof(uint64_t))
+                *counts[i] = 0;
+        }
+#endif
+    }
+
+private:
+    int fds[2];
+
+    static int OpenCounter(int cache)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        return -1;
+#endif
+    }
+};
+
+//primary rays of size by size pixels in 32 x 32 tiles, taking the tiles and each tile's rows of eight
+//pixel packets in order, as the tile renderer does. Returns the number of pixels hit.
+static int primaryordered(const std::vector<Primitive*>& prims, const vec3& eye, int size, PixelOrder order)
+{
+    const int tileSize = 32;
+    std::vector<uint32_t> tiles, packets;
+    curveorder(order, (size + tileSize - 1) / tileSize, (size + tileSize - 1) / tileSize, tiles);
+    curveorder(order, tileSize / 8, tileSize, packets);
+    
+    int hits = 0;
+    for (uint32_t tile : tiles)
+    {
+        int tileX = (tile & 0xffff) * tileSize, tileY = (tile >> 16) * tileSize;
+        for (uint32_t cell : packets)
+        {
+            int x = tileX + (cell & 0xffff) * 8, y = tileY + (cell >> 16);
+            if (x >= size || y >= size)
+                continue;
+            
+            Ray rays[8];
+            for (int i = 0; i<8; i++)
+                rays[i] = primaryray(eye, x + i, y, size);
+            RayPacket packet(rays);
+            floatx8 nearest(FLT_MAX), intersection;
+            uint64_t elements[8];
+            for (Primitive* p : prims)
+            {
+                maskx8 hit = p->RaycastPacket(packet, intersection, elements);
+                nearest = floatx8::select(hit & (intersection < nearest), intersection, nearest);
+            }
+            hits += __builtin_popcount((nearest < FLT_MAX).bits());
+        }
+    }
+    return hits;
+}
+
+//primary rays against a mesh too big for the caches, with the tiles and their packets in scanline,
+//Morton and Hilbert order, printing the L1D and LLC misses per ray where the counters can be read.
+//Nothing here measures L2 misses.
+static void benchmarkorder()
+{
+    std::vector<vec3> verts;
+    std::vector<int> inds;
+    maketorus(verts, inds);
+    Mesh* mesh = new Mesh(verts, inds);
+    std::vector<Primitive*> prims(1, mesh);
+    printf("  %d triangles, %.1f MB\n", (int)inds.size() / 3, mesh->MemoryUsage() / (1024.0 * 1024.0));
+    
+    const int size = 1024;
+    const vec3 eye(0.0f, 0.0f, -4.0f);
+    CacheCounters counters;
+    if (!counters.Available())
+        printf("  cache counters aren't available here, only timing, so the orders' effect on misses isn't measured\n");
+    
+    primaryordered(prims, eye, size, OrderScanline);
+    for (int order = 0; order<PixelOrderCount; order++)
+    {
+        //the best of three, with the counters from that run
+        double best = 1e30;
+        uint64_t l1Misses = 0, llMisses = 0;
+        int hits = 0;
+        for (int i = 0; i<3; i++)
+        {
+            counters.Start();
+            clock_t start = clock();
+            hits = primaryordered(prims, eye, size, (PixelOrder)order);
+            double seconds = (clock() - start) / (double)CLOCKS_PER_SEC;
+            counters.Stop();
+            if (seconds < best)
+            {
+                best = seconds;
+                l1Misses = counters.l1Misses;
+                llMisses = counters.llMisses;
+            }
+        }
+        
+        double rays = size * (double)size;
+        printf("  %-10s %7.2f Mrays/s", pixelordername((PixelOrder)order), rays / (best * 1000000.0));
+        if (counters.Available())
+            printf(", %6.3f L1D and %6.4f LLC read misses per ray", l1Misses / rays, llMisses / rays);
+        printf(" (%d hits)\n", hits);
+    }
+    deleteall(prims);
+}
+
+struct Benchmark
+{
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    { "box", benchmarkbox },
+    { "quad", benchmarkquad },
+    { "heightfield", benchmarkheightfield },
+    { "voxels", benchmarkvoxels },
+    { "spherecloud", benchmarkspherecloud },
+    { "curves", benchmarkcurves },
+    { "haircurves", benchmarkhaircurves },
+    { "clustermesh", benchmarkclustermesh },
+    { "vecmath", benchmarkvecmath },
+    { "matrix", benchmarkmatrix },
+    { "fastmath", benchmarkfastmath },
+    { "framebuffer", benchmarkframebuffer },
+    { "camera", benchmarkcamera },
+    { "packet", benchmarkpacket },
+    { "primary", benchmarkprimary },
+    { "order", benchmarkorder },
+};
+
+int runbenchmarks(const char* filter)
+{
+    printf("using %s kernels\n", kernellevelname(kernellevel()));
+    for (const Benchmark& b : benchmarks)
+    {
+        if (filter && !strstr(b.name, filter))
+            continue;
+        
+        printf("%s\n", b.name);
+        b.run();
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+//
+//  benchmark.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__benchmark__
+#define __Raytracer__benchmark__
+
+//runs every benchmark whose name contains filter (all of them when filter is null)
+//and prints the results. Returns the process exit code.
+int runbenchmarks(const char* filter);
+
+#endif /* defined(__Raytracer__benchmark__) */
@@ -0,0 +1,257 @@
+//
+//  bvh.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "bvh.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <stdio.h>
+
+static const int binCount = 16, maxDepth = 32;
+//nodes with at least this many items bin them and build their children on the task pool, smaller
+//ones aren't worth splitting up
+static const size_t parallelItems = 1 << 16, parallelGrain = 1 << 14;
+
+static float axisof(const vec3& v, int axis)
+{
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+template<typename Index>
+struct BVHBuilder
+{
+    typedef typename BasicBVH<Index>::Node Node;
+
+    //the bounds of a range of items and of their centers
+    struct Bounds
+    {
+        AABB items, centers;
+    };
+
+    //the items of a range sorted into binCount bins along each axis
+    struct Bins
+    {
+        AABB bounds[3][binCount];
+        Index items[3][binCount];
+    };
+
+    BasicBVH<Index>& bvh;
+    const std::vector<AABB>& itemBounds;
+    std::vector<vec3> centers;
+    int maxLeafItems;
+
+    BVHBuilder(BasicBVH<Index>& bvh, const std::vector<AABB>& itemBounds, int maxLeafItems) : bvh(bvh), itemBounds(itemBounds), maxLeafItems(maxLeafItems)
+    {
+        centers.reserve(itemBounds.size());
+        for (const AABB& b : itemBounds)
+            centers.push_back(b.Center());
+    }
+
+    Bounds GetBounds(size_t first, size_t end) const
+    {
+        Bounds bounds;
+        for (size_t i = first; i<end; i++)
+        {
+            bounds.items.Grow(itemBounds[bvh.items[i]]);
+            bounds.centers.Grow(centers[bvh.items[i]]);
+        }
+        return bounds;
+    }
+
+    Bins BinItems(size_t first, size_t end, const vec3& lo, const vec3& scale) const
+    {
+        Bins bins = {};
+        for (size_t i = first; i<end; i++)
+        {
+            Index item = bvh.items[i];
+            vec3 bin = (centers[item] - lo) * scale;
+            int bx = std::min(binCount - 1, (int)bin.x), by = std::min(binCount - 1, (int)bin.y), bz = std::min(binCount - 1, (int)bin.z);
+            bins.bounds[0][bx].Grow(itemBounds[item]);
+            bins.bounds[1][by].Grow(itemBounds[item]);
+            bins.bounds[2][bz].Grow(itemBounds[item]);
+            bins.items[0][bx]++;
+            bins.items[1][by]++;
+            bins.items[2][bz]++;
+        }
+        return bins;
+    }
+
+    //finds the cheapest binned SAH split, returning false if the centers can't be separated.
+    //The items are binned along all three axes in a single pass over them.
+    bool FindSplit(Index first, Index count, const AABB& centerBounds, int& bestAxis, float& bestPlane)
+    {
+        vec3 lo = centerBounds.min, extent = centerBounds.max - centerBounds.min;
+        vec3 scale(extent.x > 0.0f ? binCount / extent.x : 0.0f, extent.y > 0.0f ? binCount / extent.y : 0.0f, extent.z > 0.0f ? binCount / extent.z : 0.0f);
+        Bins bins;
+        if (count >= parallelItems)
+        {
+            //bins are unions and sums, the same whichever order the chunks are added in
+            bins = parallelreduce(first, first + count, parallelGrain, Bins(), [&](size_t begin, size_t end) { return BinItems(begin, end, lo, scale); }, [](Bins a, const Bins& b) {
+                for (int axis = 0; axis<3; axis++)
+                {
+                    for (int bin = 0; bin<binCount; bin++)
+                    {
+                        a.bounds[axis][bin].Grow(b.bounds[axis][bin]);
+                        a.items[axis][bin] += b.items[axis][bin];
+                    }
+                }
+                return a;
+            });
+        }
+        else
+            bins = BinItems(first, first + count, lo, scale);
+
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis<3; axis++)
+        {
+            float axisScale = axisof(scale, axis);
+            if (axisScale == 0.0f)
+                continue;
+
+            //sweep from the right to get the area of everything past each plane, then from the left
+            float rightArea[binCount];
+            Index rightItems[binCount];
+            AABB right;
+            Index rightCount = 0;
+            for (int b = binCount - 1; b>0; b--)
+            {
+                right.Grow(bins.bounds[axis][b]);
+                rightCount += bins.items[axis][b];
+                rightArea[b] = right.SurfaceArea();
+                rightItems[b] = rightCount;
+            }
+
+            AABB left;
+            Index leftCount = 0;
+            for (int b = 0; b<binCount - 1; b++)
+            {
+                left.Grow(bins.bounds[axis][b]);
+                leftCount += bins.items[axis][b];
+                float cost = left.SurfaceArea() * leftCount + rightArea[b+1] * rightItems[b+1];
+                if (leftCount > 0 && rightItems[b+1] > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestPlane = axisof(lo, axis) + (b + 1) / axisScale;
+                }
+            }
+        }
+        return bestCost < FLT_MAX;
+    }
+
+    //builds the subtree over items [first, first + count) into nodes with its root at nodeIndex
+    void Split(std::vector<Node>& nodes, Index nodeIndex, Index first, Index count, int depth)
+    {
+        Bounds itemsBounds;
+        if (count >= parallelItems)
+            itemsBounds = parallelreduce(first, first + count, parallelGrain, Bounds(), [&](size_t begin, size_t end) { return GetBounds(begin, end); }, [](Bounds a, const Bounds& b) {
+                a.items.Grow(b.items);
+                a.centers.Grow(b.centers);
+                return a;
+            });
+        else
+            itemsBounds = GetBounds(first, first + count);
+        const AABB& bounds = itemsBounds.items;
+        const AABB& centerBounds = itemsBounds.centers;
+
+        Node& node = nodes[nodeIndex];
+        node.bounds = bounds;
+        node.first = first;
+        node.count = count;
+        if (count <= (Index)maxLeafItems)
+            return;
+
+        Index* begin = bvh.items.data() + first;
+        Index* end = begin + count;
+        Index* middle = begin;
+
+        int axis;
+        float plane;
+        if (depth < maxDepth && FindSplit(first, count, centerBounds, axis, plane))
+        {
+            middle = std::partition(begin, end, [&](Index item) { return axisof(centers[item], axis) < plane; });
+        }
+
+        //fall back to halving the items along the widest axis when binning can't separate them
+        if (middle == begin || middle == end)
+        {
+            vec3 extent = centerBounds.max - centerBounds.min;
+            int widest = extent.x > extent.y && extent.x > extent.z ? 0 : (extent.y > extent.z ? 1 : 2);
+            middle = begin + count / 2;
+            std::nth_element(begin, middle, end, [&](Index a, Index b) { return axisof(centers[a], widest) < axisof(centers[b], widest); });
+        }
+
+        Index left = (Index)nodes.size();
+        nodes[nodeIndex].first = left;
+        nodes[nodeIndex].count = 0;
+        nodes.resize(left + 2);
+
+        Index leftCount = (Index)(middle - begin);
+        if (count < parallelItems)
+        {
+            Split(nodes, left, first, leftCount, depth + 1);
+            Split(nodes, left + 1, first + leftCount, count - leftCount, depth + 1);
+            return;
+        }
+
+        //the children's items don't overlap, so they can be built side by side into nodes of their
+        //own and then grafted on in the order building them one after the other would have made
+        std::vector<Node> leftNodes(1), rightNodes(1);
+        TaskGroup group;
+        group.Run([&]() { Split(leftNodes, 0, first, leftCount, depth + 1); });
+        Split(rightNodes, 0, first + leftCount, count - leftCount, depth + 1);
+        group.Wait();
+        Graft(nodes, left, leftNodes);
+        Graft(nodes, left + 1, rightNodes);
+    }
+
+    //puts a subtree built on its own into nodes, its root at rootIndex and the rest on the end
+    static void Graft(std::vector<Node>& nodes, Index rootIndex, const std::vector<Node>& subtree)
+    {
+        //subtree node i past the root goes to base + i
+        Index base = (Index)nodes.size() - 1;
+        for (size_t i = 0; i<subtree.size(); i++)
+        {
+            Node node = subtree[i];
+            if (node.count == 0)
+                node.first += base;
+            if (i == 0)
+                nodes[rootIndex] = node;
+            else
+                nodes.push_back(node);
+        }
+    }
+};
+
+template<typename Index>
+bool BasicBVH<Index>::Build(const std::vector<AABB>& itemBounds, int maxLeafItems)
+{
+    nodes.clear();
+    items.clear();
+    if (itemBounds.size() > MaxItems())
+    {
+        fprintf(stderr, "BVH: %zu items is more than the %zu %d bit indices can hold, use LargeBVH\n", itemBounds.size(), MaxItems(), (int)sizeof(Index) * 8);
+        return false;
+    }
+
+    items.resize(itemBounds.size());
+    for (Index i = 0; i<items.size(); i++)
+        items[i] = i;
+    if (items.empty())
+        return true;
+
+    nodes.reserve(items.size() * 4 / maxLeafItems + 1);
+    nodes.resize(1);
+
+    BVHBuilder<Index> builder(*this, itemBounds, maxLeafItems);
+    builder.Split(nodes, 0, 0, (Index)items.size(), 0);
+    nodes.shrink_to_fit();
+    return true;
+}
+
+template struct BasicBVH<uint32_t>;
+template struct BasicBVH<uint64_t>;
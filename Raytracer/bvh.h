@@ -0,0 +1,103 @@
+//
+//  bvh.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__bvh__
+#define __Raytracer__bvh__
+
+#include "primitives.h"
+#include <limits>
+#include <vector>
+
+//a binary bounding volume hierarchy over a list of items, built with binned SAH.
+//The hierarchy only stores item indices, the owner intersects the items in each leaf.
+//Use BVH for the compact 32 bit indices and LargeBVH past MaxItems, about two billion items.
+template<typename Index>
+struct BasicBVH
+{
+    //the packet kernels read these as PacketMesh::Node, which has to keep the same layout
+    struct Node
+    {
+        AABB bounds;
+        Index first;//first item for leaves, otherwise the index of the left child (the right follows it)
+        Index count;//number of items in a leaf, zero for inner nodes
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Index> items;//item indices in leaf order
+
+    //builds the hierarchy, splitting until leaves hold at most maxLeafItems items. Fails with an
+    //error and leaves the hierarchy empty if there are more than MaxItems items.
+    bool Build(const std::vector<AABB>& itemBounds, int maxLeafItems);
+
+    //the most items Index can hold the hierarchy of. Inner nodes refer to their children by Index
+    //too, and there can be up to twice as many nodes as items.
+    static size_t MaxItems()
+    {
+        return std::numeric_limits<Index>::max() / 2;
+    }
+
+    size_t MemoryUsage() const
+    {
+        return nodes.size() * sizeof(Node) + items.size() * sizeof(Index);
+    }
+
+    //visits the leaves the ray passes through, nearest first. leaf(first, count, tMax) tests the
+    //items items[first..first+count) and returns true if one of them was hit, shrinking tMax to the hit.
+    template<typename LeafFunc>
+    bool Traverse(const Ray& ray, float& tMax, LeafFunc leaf) const
+    {
+        if (nodes.empty())
+            return false;
+
+        float tEnter;
+        if (!nodes[0].bounds.Raycast(ray, tMax, tEnter))
+            return false;
+
+        struct Entry { Index node; float t; };
+        Entry stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = { 0, tEnter };
+
+        bool hit = false;
+        while (stackSize > 0)
+        {
+            Entry entry = stack[--stackSize];
+            if (entry.t > tMax)
+                continue;
+
+            const Node& node = nodes[entry.node];
+            if (node.count > 0)
+            {
+                if (leaf(node.first, node.count, tMax))
+                    hit = true;
+                continue;
+            }
+
+            //push the further child first so the nearer one is visited next
+            float tLeft, tRight;
+            bool hitLeft = nodes[node.first].bounds.Raycast(ray, tMax, tLeft);
+            bool hitRight = nodes[node.first + 1].bounds.Raycast(ray, tMax, tRight);
+            if (hitLeft && hitRight)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[stackSize++] = { leftFirst ? node.first + 1 : node.first, leftFirst ? tRight : tLeft };
+                stack[stackSize++] = { leftFirst ? node.first : node.first + 1, leftFirst ? tLeft : tRight };
+            }
+            else if (hitLeft)
+                stack[stackSize++] = { node.first, tLeft };
+            else if (hitRight)
+                stack[stackSize++] = { node.first + 1, tRight };
+        }
+        return hit;
+    }
+};
+
+typedef BasicBVH<uint32_t> BVH;
+typedef BasicBVH<uint64_t> LargeBVH;
+
+#endif /* defined(__Raytracer__bvh__) */
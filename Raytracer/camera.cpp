@@ -0,0 +1,88 @@
+//
+//  camera.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "camera.h"
+#include "matrixmaths.h"
+#include <algorithm>
+
+Camera::Camera(const vec3& position, const vec3& target, const vec3& up, float fov, int width, int height) : position(position), fov(fov), aspect(width / (float)height), width(width), height(height)
+{
+    vec3 forward = (target - position).normalize();
+    vec3 right = up.cross(forward).normalize();
+    vec3 cameraUp = forward.cross(right);
+    cameraToWorld = {{
+        right.x, cameraUp.x, forward.x, position.x,
+        right.y, cameraUp.y, forward.y, position.y,
+        right.z, cameraUp.z, forward.z, position.z,
+        0.0f,    0.0f,       0.0f,      1.0f
+    }};
+
+    //the image plane is one unit in front of the camera, each pixel is the same size across and up
+    float halfHeight = tanf(fov * 0.5f), halfWidth = halfHeight * aspect;
+    float pixelSize = 2.0f * halfHeight / height;
+    corner = transformDirection(cameraToWorld, vec3(pixelSize * 0.5f - halfWidth, pixelSize * 0.5f - halfHeight, 1.0f));
+    stepX = transformDirection(cameraToWorld, vec3(pixelSize, 0.0f, 0.0f));
+    stepY = transformDirection(cameraToWorld, vec3(0.0f, pixelSize, 0.0f));
+}
+
+//the packets step along the row from the same start the single rays do and normalize the same way,
+//so a pixel gets exactly the same ray from either.
+Ray Camera::GetRay(int x, int y) const
+{
+    vec3 direction = (corner + stepY * (float)y) + stepX * (float)x;
+    return Ray(position, direction * (1.0f / direction.length()));
+}
+
+Ray Camera::GetSampleRay(float x, float y) const
+{
+    vec3 direction = (corner + stepY * y) + stepX * x;
+    return Ray(position, direction * (1.0f / direction.length()));
+}
+
+RayPacket Camera::GetPacket(int x, int y, int count) const
+{
+    float columns[8];
+    for (int i = 0; i<8; i++)
+        columns[i] = (float)(x + std::min(i, count - 1));
+
+    vec3x8 row(corner + stepY * (float)y);
+    vec3x8 direction = row + vec3x8(stepX) * floatx8::load(columns);
+    return RayPacket(vec3x8(position), direction.normalize());
+}
+
+RayPacket Camera::GetPacket(int x, int y, int count, const float* offsetX, const float* offsetY) const
+{
+    float columns[8], rows[8];
+    for (int i = 0; i<8; i++)
+    {
+        columns[i] = (float)(x + std::min(i, count - 1)) + offsetX[i];
+        rows[i] = (float)y + offsetY[i];
+    }
+
+    vec3x8 direction = vec3x8(corner) + vec3x8(stepY) * floatx8::load(rows) + vec3x8(stepX) * floatx8::load(columns);
+    return RayPacket(vec3x8(position), direction.normalize());
+}
+
+void Camera::GetRays(int x, int y, int count, Ray* rays) const
+{
+    for (int i = 0; i<count; i+=8)
+    {
+        int lanes = std::min(8, count - i);
+        RayPacket packet = GetPacket(x + i, y, lanes);
+
+        //copy the lanes straight out, the packet has already worked out the inverse directions
+        const float* f = packet.Floats();
+        for (int lane = 0; lane<lanes; lane++)
+        {
+            Ray& ray = rays[i + lane];
+            ray.origin = position;
+            ray.direction = vec3(f[24 + lane], f[32 + lane], f[40 + lane]);
+            ray.invDirection = vec3(f[48 + lane], f[56 + lane], f[64 + lane]);
+        }
+    }
+}
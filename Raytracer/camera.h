@@ -0,0 +1,44 @@
+//
+//  camera.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__camera__
+#define __Raytracer__camera__
+
+#include "maths.h"
+#include "primitives.h"
+
+//a pinhole camera at position looking towards target, with fov the vertical field of view in
+//radians. Rays go through the centres of the pixels of a width by height image, with rows going up
+//from the bottom as OpenGL textures do.
+struct Camera
+{
+    vec3 position;
+    float fov, aspect;
+    int width, height;
+    //camera space (x right, y up, z forward) to world space
+    mat4 cameraToWorld;
+
+    Camera(const vec3& position, const vec3& target, const vec3& up, float fov, int width, int height);
+
+    //the ray through pixel x, y
+    Ray GetRay(int x, int y) const;
+    //the ray through a point anywhere on the image, pixel centres being at whole x and y
+    Ray GetSampleRay(float x, float y) const;
+    //count rays along row y from column x, eight at a time
+    void GetRays(int x, int y, int count, Ray* rays) const;
+    //up to eight rays along row y from column x, lanes past count repeating the last one
+    RayPacket GetPacket(int x, int y, int count) const;
+    //the same but with each lane's ray moved offsetX[lane], offsetY[lane] pixels from the centre
+    RayPacket GetPacket(int x, int y, int count, const float* offsetX, const float* offsetY) const;
+
+private:
+    //the unnormalized direction through pixel 0, 0 and how much it changes for each column and row
+    vec3 corner, stepX, stepY;
+};
+
+#endif /* defined(__Raytracer__camera__) */
@@ -0,0 +1,310 @@
+//
+//  curves.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "curves.h"
+#include <algorithm>
+#include <string.h>
+
+//builds two axes perpendicular to the normalized n (Duff et al. 2017).
+static void basis(const vec3& n, vec3& b1, vec3& b2)
+{
+    float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + n.z);
+    float b = n.x * n.y * a;
+    b1 = vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    b2 = vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+static vec3 bezier(const vec3* cp, float t)
+{
+    float s = 1.0f - t;
+    return cp[0] * (s*s*s) + cp[1] * (3.0f*s*s*t) + cp[2] * (3.0f*s*t*t) + cp[3] * (t*t*t);
+}
+
+static vec3 beziertangent(const vec3* cp, float t)
+{
+    float s = 1.0f - t;
+    return (cp[1] - cp[0]) * (3.0f*s*s) + (cp[2] - cp[1]) * (6.0f*s*t) + (cp[3] - cp[2]) * (3.0f*t*t);
+}
+
+static vec3 lerp(const vec3& a, const vec3& b, float t)
+{
+    return a + (b - a) * t;
+}
+
+//the control points of the part of the curve from u0 to u1, from the curve's blossom.
+static void subcurve(const vec3* cp, float u0, float u1, vec3* out)
+{
+    const float ts[4][3] = { { u0, u0, u0 }, { u0, u0, u1 }, { u0, u1, u1 }, { u1, u1, u1 } };
+    for (int i = 0; i<4; i++)
+    {
+        vec3 a0 = lerp(cp[0], cp[1], ts[i][0]), a1 = lerp(cp[1], cp[2], ts[i][0]), a2 = lerp(cp[2], cp[3], ts[i][0]);
+        vec3 b0 = lerp(a0, a1, ts[i][1]), b1 = lerp(a1, a2, ts[i][1]);
+        out[i] = lerp(b0, b1, ts[i][2]);
+    }
+}
+
+//surface area of the bounds of the control points, grown by r.
+static float curvearea(const vec3* cp, float r)
+{
+    vec3 e = cp[0].max(cp[1]).max(cp[2].max(cp[3])) - cp[0].min(cp[1]).min(cp[2].min(cp[3])) + vec3(r, r, r) * 2.0f;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+Curves::Curves(std::vector<CurveSegment> input)
+{
+    //the hierarchy is built from axis aligned boxes, which around a long diagonal strand are mostly
+    //empty and overlap everything nearby. Such segments are split into up to maxPieces pieces along
+    //the curve, halving them while that shrinks their boxes' total surface area by a third or more
+    std::vector<Piece> unordered;
+    {
+        std::vector<AABB> bounds;
+        bounds.reserve(input.size());
+        for (uint32_t i = 0; i<(uint32_t)input.size(); i++)
+        {
+            const CurveSegment& s = input[i];
+            const vec3 cp[4] = { s.p0, s.p1, s.p2, s.p3 };
+            float r = std::max(s.width0, s.width1) * 0.5f;
+
+            int count = 1;
+            float area = curvearea(cp, r);
+            while (count < maxPieces)
+            {
+                float split = 0.0f;
+                for (int k = 0; k<count * 2; k++)
+                {
+                    vec3 piece[4];
+                    subcurve(cp, k / (count * 2.0f), (k + 1) / (count * 2.0f), piece);
+                    split += curvearea(piece, r);
+                }
+                if (split > area * (2.0f / 3.0f))
+                    break;
+                count *= 2;
+                area = split;
+            }
+
+            for (int k = 0; k<count; k++)
+            {
+                Piece piece = { i, k / (float)count, (k + 1) / (float)count };
+                vec3 sub[4];
+                subcurve(cp, piece.u0, piece.u1, sub);
+                AABB b;
+                for (const vec3& p : sub)
+                    b.Grow(p);
+                bounds.push_back(AABB(b.min - vec3(r, r, r), b.max + vec3(r, r, r)));
+                unordered.push_back(piece);
+            }
+        }
+        bvh.Build(bounds, 4);
+    }
+
+    //store the pieces in leaf order, and the segments in the order their first piece appears along
+    //with their oriented boxes
+    std::vector<uint32_t> remap(input.size(), UINT32_MAX);
+    segments.reserve(input.size());
+    boxes.reserve(input.size());
+    pieces.reserve(unordered.size());
+    for (uint32_t item : bvh.items)
+    {
+        Piece piece = unordered[item];
+        uint32_t& index = remap[piece.segment];
+        if (index == UINT32_MAX)
+        {
+            index = (uint32_t)segments.size();
+            const CurveSegment& s = input[piece.segment];
+            segments.push_back(s);
+
+            //the convex hull of the control points bounds the curve, so their extents along
+            //each axis give the box
+            OrientedBox box;
+            vec3 chord = s.p3 - s.p0;
+            if (chord.lengthSq() < 1e-12f)
+                chord = s.p2 - s.p1;
+            box.u = chord.lengthSq() < 1e-12f ? vec3(0.0f, 1.0f, 0.0f) : chord.normalize();
+            basis(box.u, box.v, box.w);
+
+            float r = std::max(s.width0, s.width1) * 0.5f;
+            box.min = vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+            box.max = vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const vec3* p : { &s.p0, &s.p1, &s.p2, &s.p3 })
+            {
+                vec3 local(p->dot(box.u), p->dot(box.v), p->dot(box.w));
+                box.min = box.min.min(local);
+                box.max = box.max.max(local);
+            }
+            box.min = box.min - vec3(r, r, r);
+            box.max = box.max + vec3(r, r, r);
+            boxes.push_back(box);
+        }
+        piece.segment = index;
+        pieces.push_back(piece);
+    }
+    std::vector<uint32_t>().swap(bvh.items);
+}
+
+size_t Curves::MemoryUsage() const
+{
+    return segments.size() * sizeof(CurveSegment) + boxes.size() * sizeof(OrientedBox) + pieces.size() * sizeof(Piece) + bvh.MemoryUsage();
+}
+
+void Curves::BoundsVolume(float& aligned, float& oriented) const
+{
+    aligned = oriented = 0.0f;
+    for (size_t i = 0; i<segments.size(); i++)
+    {
+        const CurveSegment& s = segments[i];
+        float r = std::max(s.width0, s.width1) * 0.5f;
+        vec3 lo = s.p0.min(s.p1).min(s.p2.min(s.p3)) - vec3(r, r, r);
+        vec3 hi = s.p0.max(s.p1).max(s.p2.max(s.p3)) + vec3(r, r, r);
+        vec3 a = hi - lo, o = boxes[i].max - boxes[i].min;
+        aligned += a.x * a.y * a.z;
+        oriented += o.x * o.y * o.z;
+    }
+}
+
+//recursively splits the curve, given in ray space where the ray runs along +z from the origin,
+//until the pieces are flat enough to treat as straight tubes.
+static bool intersectcurve(const vec3* cp, float u0, float u1, int depth, const CurveSegment& s, float maxRadius, float& tMax, float& u)
+{
+    //reject pieces whose bounds don't contain the ray
+    vec3 lo = cp[0].min(cp[1]).min(cp[2].min(cp[3])) - vec3(maxRadius, maxRadius, maxRadius);
+    vec3 hi = cp[0].max(cp[1]).max(cp[2].max(cp[3])) + vec3(maxRadius, maxRadius, maxRadius);
+    if (lo.x > 0.0f || hi.x < 0.0f || lo.y > 0.0f || hi.y < 0.0f || hi.z < 0.0f || lo.z > tMax)
+        return false;
+
+    if (depth > 0)
+    {
+        //de Casteljau split at the middle
+        vec3 a = (cp[0] + cp[1]) * 0.5f, b = (cp[1] + cp[2]) * 0.5f, c = (cp[2] + cp[3]) * 0.5f;
+        vec3 ab = (a + b) * 0.5f, bc = (b + c) * 0.5f, mid = (ab + bc) * 0.5f;
+        vec3 left[4] = { cp[0], a, ab, mid }, right[4] = { mid, bc, c, cp[3] };
+        float um = (u0 + u1) * 0.5f;
+        bool hitLeft = intersectcurve(left, u0, um, depth - 1, s, maxRadius, tMax, u);
+        bool hitRight = intersectcurve(right, um, u1, depth - 1, s, maxRadius, tMax, u);
+        return hitLeft || hitRight;
+    }
+
+    //the ray must pass between the lines perpendicular to the piece at either end
+    if ((cp[1].y - cp[0].y) * -cp[0].y + cp[0].x * (cp[0].x - cp[1].x) < 0.0f)
+        return false;
+    if ((cp[2].y - cp[3].y) * -cp[3].y + cp[3].x * (cp[3].x - cp[2].x) < 0.0f)
+        return false;
+
+    //closest point on the piece to the ray
+    float dx = cp[3].x - cp[0].x, dy = cp[3].y - cp[0].y;
+    float denom = dx*dx + dy*dy;
+    if (denom == 0.0f)
+        return false;
+    float w = std::min(std::max(-(cp[0].x * dx + cp[0].y * dy) / denom, 0.0f), 1.0f);
+    float hitU = u0 + (u1 - u0) * w;
+    float radius = (s.width0 + (s.width1 - s.width0) * hitU) * 0.5f;
+    vec3 pc = bezier(cp, w);
+    float distSq = pc.x*pc.x + pc.y*pc.y;
+    if (distSq > radius * radius)
+        return false;
+
+    //step back from the centre line to the surface of a round tube
+    float t = pc.z - sqrtf(radius * radius - distSq);
+    if (t <= 0.0001f || t >= tMax)
+        return false;
+
+    tMax = t;
+    u = hitU;
+    return true;
+}
+
+bool Curves::RaycastPiece(const Ray& ray, const vec3& dx, const vec3& dy, uint32_t index, float& tMax, float& u) const
+{
+    //cheap rejection against the segment's oriented box first
+    const Piece& piece = pieces[index];
+    const OrientedBox& box = boxes[piece.segment];
+    vec3 o(ray.origin.dot(box.u), ray.origin.dot(box.v), ray.origin.dot(box.w));
+    vec3 d(ray.direction.dot(box.u), ray.direction.dot(box.v), ray.direction.dot(box.w));
+    vec3 invd(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+    vec3 t0 = (box.min - o) * invd, t1 = (box.max - o) * invd;
+    float tNear = t0.min(t1).maxComponent(), tFar = t0.max(t1).minComponent();
+    if (tNear > tFar || tFar < 0.0f || tNear > tMax)
+        return false;
+
+    const CurveSegment& s = segments[piece.segment];
+    vec3 cp[4];
+    const vec3* p[4] = { &s.p0, &s.p1, &s.p2, &s.p3 };
+    for (int i = 0; i<4; i++)
+    {
+        vec3 rel = *p[i] - ray.origin;
+        cp[i] = vec3(rel.dot(dx), rel.dot(dy), rel.dot(ray.direction));
+    }
+    if (piece.u0 != 0.0f || piece.u1 != 1.0f)
+    {
+        vec3 whole[4] = { cp[0], cp[1], cp[2], cp[3] };
+        subcurve(whole, piece.u0, piece.u1, cp);
+    }
+
+    //pick the subdivision depth from how far the curve bends relative to its width
+    float maxWidth = std::max(s.width0, s.width1);
+    float bend = 0.0f;
+    for (int i = 0; i<2; i++)
+    {
+        vec3 b = cp[i] - cp[i+1] * 2.0f + cp[i+2];
+        bend = std::max(bend, std::max(fabsf(b.x), std::max(fabsf(b.y), fabsf(b.z))));
+    }
+    float eps = maxWidth * 0.05f;
+    int depth = bend > 0.0f ? std::min(std::max((int)roundf(log2f(1.41421356f * 6.0f * bend / (8.0f * eps)) * 0.5f), 0), 10) : 0;
+
+    return intersectcurve(cp, piece.u0, piece.u1, depth, s, maxWidth * 0.5f, tMax, u);
+}
+
+bool Curves::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    vec3 dx, dy;
+    basis(ray.direction, dx, dy);
+
+    float tMax = FLT_MAX;
+    bool hit = bvh.Traverse(ray, tMax, [&](uint32_t first, uint32_t count, float& t)
+    {
+        bool found = false;
+        for (uint32_t i = first; i<first + count; i++)
+        {
+            float u;
+            if (RaycastPiece(ray, dx, dy, i, t, u))
+            {
+                uint32_t ubits;
+                memcpy(&ubits, &u, sizeof(u));
+                element = (uint64_t)ubits << 32 | pieces[i].segment;
+                found = true;
+            }
+        }
+        return found;
+    });
+
+    intersection = tMax;
+    return hit;
+}
+
+vec3 Curves::GetNormal(const vec3& pos, uint64_t element)
+{
+    const CurveSegment& s = segments[(uint32_t)element];
+    uint32_t ubits = (uint32_t)(element >> 32);
+    float u;
+    memcpy(&u, &ubits, sizeof(u));
+
+    //points away from the centre line, perpendicular to the curve
+    vec3 cp[4] = { s.p0, s.p1, s.p2, s.p3 };
+    vec3 tangent = beziertangent(cp, u);
+    vec3 n = pos - bezier(cp, u);
+    float tangentLenSq = tangent.lengthSq();
+    if (tangentLenSq > 0.0f)
+        n = n - tangent * (n.dot(tangent) / tangentLenSq);
+    if (n.lengthSq() == 0.0f)
+    {
+        vec3 b1, b2;
+        basis(tangent.normalize(), b1, b2);
+        return b1;
+    }
+    return n.normalize();
+}
@@ -0,0 +1,88 @@
+//
+//  curves.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__curves__
+#define __Raytracer__curves__
+
+#include "bvh.h"
+
+//a cubic bezier segment of a strand, with its width at either end.
+struct CurveSegment
+{
+    vec3 p0, p1, p2, p3;
+    float width0, width1;
+};
+
+//many thin round curve segments (hair, fur, grass) sharing one material. Long diagonal segments
+//are split into pieces along the curve so the hierarchy's axis aligned boxes stay close to them,
+//and each segment has an oriented box lined up with its end points which is tested before the
+//curve itself. Curves are intersected by recursive subdivision in ray space, treating the final
+//pieces as round tubes.
+struct Curves : Primitive
+{
+    Curves(std::vector<CurveSegment> segments);
+
+    virtual Primitive* Clone() const
+    {
+        return new Curves(*this);
+    }
+
+    //the element returned holds the segment index in the low 32 bits and the float bits of
+    //the curve parameter at the hit in the high 32 bits
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        if (bvh.nodes.empty())
+            return false;
+        bounds = bvh.nodes[0].bounds;
+        return true;
+    }
+
+    //bytes used by the segments, their oriented boxes, the pieces and the hierarchy.
+    size_t MemoryUsage() const;
+
+    //total volume of the segments' axis aligned and oriented boxes.
+    void BoundsVolume(float& aligned, float& oriented) const;
+
+    size_t SegmentCount() const
+    {
+        return segments.size();
+    }
+
+    size_t PieceCount() const
+    {
+        return pieces.size();
+    }
+
+private:
+    static const int maxPieces = 4;
+
+    //the part of a segment between two curve parameters, each a leaf item of the hierarchy
+    struct Piece
+    {
+        uint32_t segment;
+        float u0, u1;
+    };
+
+    struct OrientedBox
+    {
+        vec3 u, v, w;//axes, u runs from the first to the last control point
+        vec3 min, max;//extents along each axis
+    };
+
+    std::vector<CurveSegment> segments;//in the order their first piece is reached in the leaves
+    std::vector<OrientedBox> boxes;
+    std::vector<Piece> pieces;//in leaf order
+    BVH bvh;
+
+    bool RaycastPiece(const Ray& ray, const vec3& dx, const vec3& dy, uint32_t index, float& tMax, float& u) const;
+};
+
+#endif /* defined(__Raytracer__curves__) */
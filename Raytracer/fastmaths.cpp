@@ -0,0 +1,11 @@
+//
+//  fastmaths.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "fastmaths.h"
+
+bool fastMath = FAST_MATH;
@@ -0,0 +1,138 @@
+//
+//  fastmaths.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__fastmaths__
+#define __Raytracer__fastmaths__
+
+#include "maths.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+//Approximations for the maths the shading does at every hit, traded for a bounded loss of accuracy.
+//The maximum errors are relative to the exact result over all positive finite floats unless noted,
+//measured against double precision. The shading only uses them when fastMath is set, which starts
+//as FAST_MATH (define it to 1 to build with fast maths on) and can be switched with -fastmath.
+#ifndef FAST_MATH
+#define FAST_MATH 0
+#endif
+
+extern bool fastMath;
+
+inline uint32_t floatbits(float f) { uint32_t i; memcpy(&i, &f, 4); return i; }
+inline float bitsfloat(uint32_t i) { float f; memcpy(&f, &i, 4); return f; }
+
+//1/sqrt(x), from the 12 bit hardware estimate refined with one Newton step. Max error 3e-7 with SSE,
+//without it the estimate comes from the bits of x and takes two steps for 5e-6.
+inline float fastrsqrt(float x)
+{
+#if defined(__SSE__)
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#else
+    float y = bitsfloat(0x5f375a86 - (floatbits(x) >> 1));
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y * (1.5f - 0.5f * x * y * y);
+#endif
+}
+
+//v.normalize() with a multiply by fastrsqrt instead of a square root and three divides.
+inline vec3 fastnormalize(const vec3& v)
+{
+    return v * fastrsqrt(v.lengthSq());
+}
+
+//x to a constant integer power by repeated squaring, a multiply per bit of n that unrolls completely.
+//Exact up to the rounding of each multiply, so within 1e-6 of powf for the powers the shading uses.
+template<unsigned int n>
+inline float powi(float x)
+{
+    float half = powi<n / 2>(x);
+    return n & 1 ? half * half * x : half * half;
+}
+
+template<>
+inline float powi<0>(float x)
+{
+    return 1.0f;
+}
+
+//powi for an exponent only known at runtime, walking the bits of n from the top so it does the same
+//multiplies in the same order as powi<n> and gives the same results.
+inline float powi(float x, unsigned int n)
+{
+    float result = 1.0f;
+    for (int bit = 31; bit >= 0; bit--)
+    {
+        result *= result;
+        if ((n >> bit) & 1)
+            result *= x;
+    }
+    return result;
+}
+
+//e^x, splitting x into 2^n * e^r with |r| <= ln(2)/2 and a degree 6 polynomial for e^r. Max error 3e-7,
+//clamping x to -87 to 88 so the result stays a normal float.
+inline float fastexp(float x)
+{
+    x = x < -87.0f ? -87.0f : (x > 88.0f ? 88.0f : x);
+
+    //adding 1.5 * 2^23 rounds to the nearest integer and leaves it in the low mantissa bits
+    float shifted = x * 1.44269504f + 12582912.0f;
+    float n = shifted - 12582912.0f;
+    float r = x - n * 0.693145752f - n * 1.42860677e-6f;
+    float p = 1.0f + r * (1.0f + r * (0.5f + r * (1.0f / 6.0f + r * (1.0f / 24.0f + r * (1.0f / 120.0f + r * (1.0f / 720.0f))))));
+    return p * bitsfloat((floatbits(shifted) + 127) << 23);
+}
+
+//ln(x) for positive normal x, splitting it into m * 2^e with m in [sqrt(1/2), sqrt(2)) and taking
+//ln(m) = 2 atanh((m-1)/(m+1)) from its series. Max error 1.5e-7, or 1e-7 absolute where |ln(x)| < 1.
+inline float fastlog(float x)
+{
+    uint32_t bits = floatbits(x);
+    int e = (int)((bits >> 23) & 0xff) - 127;
+    float m = bitsfloat((bits & 0x007fffff) | 0x3f800000);
+    if (m > 1.41421356f)
+    {
+        m *= 0.5f;
+        e++;
+    }
+
+    float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+    float atanh = s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f + s2 * (1.0f / 9.0f)))));
+    return e * 0.693145752f + (e * 1.42860677e-6f + 2.0f * atanh);
+}
+
+//x^y for positive x and any y, through fastexp and fastlog. The error grows with |y ln(x)|, max 2e-6
+//while that stays under 10.
+inline float fastpow(float x, float y)
+{
+    return fastexp(y * fastlog(x));
+}
+
+//the normalize and power the shading uses, picked by fastMath
+inline vec3 shadenormalize(vec3 v)
+{
+    return fastMath ? fastnormalize(v) : v.normalize();
+}
+
+template<unsigned int n>
+inline float shadepow(float x)
+{
+    return fastMath ? powi<n>(x) : powf(x, (float)n);
+}
+
+inline float shadepow(float x, unsigned int n)
+{
+    return fastMath ? powi(x, n) : powf(x, (float)n);
+}
+
+#endif /* defined(__Raytracer__fastmaths__) */
@@ -0,0 +1,96 @@
+//
+//  framebuffer.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "framebuffer.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+//Channels are quantized to 12 bits before the lookup. That is fine enough that neighbouring entries
+//never skip an output value, even where the sRGB curve is steepest near black.
+static const int lutSize = 4096;
+
+//a lookup table from quantized linear channel to output byte, in 8.8 fixed point so the dither can
+//be added to the fraction before it's dropped
+struct PixelLUT
+{
+    uint16_t values[lutSize];
+
+    PixelLUT(bool srgb)
+    {
+        for (int i = 0; i<lutSize; i++)
+        {
+            float c = i / (float)(lutSize - 1);
+            if (srgb)
+                c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            values[i] = (uint16_t)(c * 255.0f * 256.0f + 0.5f);
+        }
+    }
+};
+
+//4x4 Bayer matrix, spreading the thresholds evenly over each block of pixels
+static const uint8_t bayer[4][4] =
+{
+    { 0, 8, 2, 10 },
+    { 12, 4, 14, 6 },
+    { 3, 11, 1, 9 },
+    { 15, 7, 13, 5 }
+};
+
+//converts columns startX up to endX of rows startY up to endY of an image width pixels across
+static void convertrows(const vec3* radiance, int width, int startX, int endX, int startY, int endY, const PixelFormat& format, unsigned char* pixels)
+{
+    static const PixelLUT srgbLUT(true), linearLUT(false);
+    const uint16_t* lut = format.srgb ? srgbLUT.values : linearLUT.values;
+    int channels = format.layout == PixelRGBA8 ? 4 : 3;
+
+    const PacketKernels& kernels = packetkernels();
+    std::vector<uint32_t> indices((endX - startX) * 3);
+    for (int y = startY; y<endY; y++)
+    {
+        kernels.quantize(&radiance[y * width + startX].x, lutSize - 1, indices.data(), indices.size());
+
+        //without dithering every pixel rounds to nearest, adding half of the fraction
+        uint32_t rounding[4] = { 128, 128, 128, 128 };
+        if (format.dither)
+        {
+            for (int x = 0; x<4; x++)
+                rounding[x] = bayer[y & 3][x] * 16 + 8;
+        }
+
+        unsigned char* row = pixels + ((size_t)y * width + startX) * channels;
+        for (int x = startX; x<endX; x++)
+        {
+            uint32_t r = rounding[x & 3];
+            const uint32_t* index = &indices[(x - startX) * 3];
+            row[0] = (unsigned char)((lut[index[0]] + r) >> 8);
+            row[1] = (unsigned char)((lut[index[1]] + r) >> 8);
+            row[2] = (unsigned char)((lut[index[2]] + r) >> 8);
+            if (channels == 4)
+                row[3] = 255;
+            row += channels;
+        }
+    }
+}
+
+void convertpixels(const vec3* radiance, int width, int height, const PixelFormat& format, unsigned char* pixels)
+{
+    static_assert(sizeof(vec3) == sizeof(float) * 3, "radiance is quantized as a flat array of floats");
+
+    //a few rows at a time, enough to be worth handing to another worker
+    parallelfor(0, height, 16, [&](size_t startY, size_t endY) {
+        convertrows(radiance, width, 0, width, (int)startY, (int)endY, format, pixels);
+    });
+}
+
+void convertregion(const vec3* radiance, int width, int x, int y, int regionWidth, int regionHeight, const PixelFormat& format, unsigned char* pixels)
+{
+    convertrows(radiance, width, x, x + regionWidth, y, y + regionHeight, format, pixels);
+}
@@ -0,0 +1,43 @@
+//
+//  framebuffer.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__framebuffer__
+#define __Raytracer__framebuffer__
+
+#include "maths.h"
+
+//Turns the float radiance the renderers produce into 8 bit pixels, in one pass over the whole image or
+//a rectangle of it at a time.
+//Channels are clamped and quantized with the SIMD kernels, then mapped through a lookup table that
+//either sRGB encodes them or leaves them linear.
+enum PixelLayout
+{
+    PixelRGB8,
+    //RGB8 with an opaque alpha byte after each pixel
+    PixelRGBA8
+};
+
+struct PixelFormat
+{
+    PixelLayout layout;
+    //sRGB encodes the channels, for displays that expect it. Otherwise they're written linear.
+    bool srgb;
+    //adds a 4x4 ordered dither before rounding to hide banding in smooth gradients
+    bool dither;
+
+    PixelFormat() : layout(PixelRGB8), srgb(true), dither(false)
+    { }
+};
+
+//converts width * height colours to pixels in format, splitting the rows across the task pool.
+void convertpixels(const vec3* radiance, int width, int height, const PixelFormat& format, unsigned char* pixels);
+//converts just the regionWidth * regionHeight rectangle at x, y of an image width pixels across, on
+//the calling thread, for renderers that hand over their pixels a tile at a time
+void convertregion(const vec3* radiance, int width, int x, int y, int regionWidth, int regionHeight, const PixelFormat& format, unsigned char* pixels);
+
+#endif /* defined(__Raytracer__framebuffer__) */
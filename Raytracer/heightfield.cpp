@@ -0,0 +1,229 @@
+//
+//  heightfield.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "heightfield.h"
+#include <float.h>
+#include <stdio.h>
+#include <algorithm>
+#include <utility>
+
+//checks there's at least one cell, a positive cell size and a sample for every grid point
+static bool validfield(float cellSize, int width, int depth, size_t samples)
+{
+    if (width < 2 || depth < 2)
+    {
+        fprintf(stderr, "Heightfield: %d x %d samples don't make a single cell\n", width, depth);
+        return false;
+    }
+    if (!(cellSize > 0.0f) || !isfinite(cellSize))
+    {
+        fprintf(stderr, "Heightfield: the cell size %f isn't a finite positive number\n", cellSize);
+        return false;
+    }
+    if (samples < (size_t)width * (size_t)depth)
+    {
+        fprintf(stderr, "Heightfield: %zu heights aren't enough for %d x %d samples\n", samples, width, depth);
+        return false;
+    }
+    return true;
+}
+
+Heightfield::Heightfield(vec3 origin, float cellSize, int width, int depth, std::vector<float> heights) :
+    origin(origin), cellSize(cellSize), width(width), depth(depth), heights(std::move(heights)), boundsMin(origin), boundsMax(origin)
+{
+    if (!validfield(cellSize, width, depth, this->heights.size()))
+    {
+        this->width = this->depth = 0;
+        this->heights.clear();
+        return;
+    }
+
+    //first level straight from the samples, each block also covers the samples on its far edges
+    int blockCells = 1 << firstLevel;
+    Level level;
+    level.width = std::max(1, (width - 2) / blockCells + 1);
+    level.depth = std::max(1, (depth - 2) / blockCells + 1);
+    level.ranges.resize((size_t)level.width * level.depth);
+    for (int bz = 0; bz<level.depth; bz++)
+    {
+        for (int bx = 0; bx<level.width; bx++)
+        {
+            Range r = { FLT_MAX, -FLT_MAX };
+            int x1 = std::min(width - 1, (bx + 1) * blockCells), z1 = std::min(depth - 1, (bz + 1) * blockCells);
+            for (int z = bz * blockCells; z<=z1; z++)
+            {
+                for (int x = bx * blockCells; x<=x1; x++)
+                {
+                    r.min = std::min(r.min, Height(x, z));
+                    r.max = std::max(r.max, Height(x, z));
+                }
+            }
+            level.ranges[(size_t)bz * level.width + bx] = r;
+        }
+    }
+    levels.push_back(level);
+
+    //then halve the resolution until a single block covers the whole grid
+    while (levels.back().width > 1 || levels.back().depth > 1)
+    {
+        const Level& prev = levels.back();
+        Level next;
+        next.width = (prev.width + 1) / 2;
+        next.depth = (prev.depth + 1) / 2;
+        next.ranges.resize((size_t)next.width * next.depth);
+        for (int bz = 0; bz<next.depth; bz++)
+        {
+            for (int bx = 0; bx<next.width; bx++)
+            {
+                Range r = { FLT_MAX, -FLT_MAX };
+                for (int z = bz * 2; z<std::min(bz * 2 + 2, prev.depth); z++)
+                {
+                    for (int x = bx * 2; x<std::min(bx * 2 + 2, prev.width); x++)
+                    {
+                        const Range& child = prev.ranges[(size_t)z * prev.width + x];
+                        r.min = std::min(r.min, child.min);
+                        r.max = std::max(r.max, child.max);
+                    }
+                }
+                next.ranges[(size_t)bz * next.width + bx] = r;
+            }
+        }
+        levels.push_back(next);
+    }
+
+    const Range& top = levels.back().ranges[0];
+    boundsMin = vec3(origin.x, top.min, origin.z);
+    boundsMax = vec3(origin.x + (width - 1) * cellSize, top.max, origin.z + (depth - 1) * cellSize);
+}
+
+size_t Heightfield::MemoryUsage() const
+{
+    size_t bytes = heights.size() * sizeof(float);
+    for (const Level& level : levels)
+        bytes += level.ranges.size() * sizeof(Range);
+    return bytes;
+}
+
+Heightfield::Range Heightfield::CellRange(int level, int x, int z) const
+{
+    if (level > 0)
+    {
+        const Level& l = levels[level - firstLevel];
+        return l.ranges[(size_t)z * l.width + x];
+    }
+
+    float h00 = Height(x, z), h10 = Height(x+1, z), h01 = Height(x, z+1), h11 = Height(x+1, z+1);
+    Range r = { std::min(std::min(h00, h10), std::min(h01, h11)), std::max(std::max(h00, h10), std::max(h01, h11)) };
+    return r;
+}
+
+bool Heightfield::RaycastCell(const Ray& ray, int x, int z, float& intersection) const
+{
+    vec3 p00 = origin + vec3(x * cellSize, Height(x, z), z * cellSize);
+    vec3 p10 = origin + vec3((x+1) * cellSize, Height(x+1, z), z * cellSize);
+    vec3 p01 = origin + vec3(x * cellSize, Height(x, z+1), (z+1) * cellSize);
+    vec3 p11 = origin + vec3((x+1) * cellSize, Height(x+1, z+1), (z+1) * cellSize);
+
+    //the cell is split along the p00-p11 diagonal
+    float t1 = FLT_MAX, t2 = FLT_MAX;
+    bool hit1 = RaycastTriangle(ray, p00, p10 - p00, p11 - p00, t1);
+    bool hit2 = RaycastTriangle(ray, p00, p11 - p00, p01 - p00, t2);
+    if (!hit1 && !hit2)
+        return false;
+
+    intersection = std::min(hit1 ? t1 : FLT_MAX, hit2 ? t2 : FLT_MAX);
+    return true;
+}
+
+bool Heightfield::Traverse(const Ray& ray, int level, int blockX, int blockZ, float tMin, float tMax, float& intersection) const
+{
+    int childLevel = level > firstLevel ? level - 1 : 0;
+    int perBlock = 1 << (level - childLevel);
+    int gridWidth = childLevel > 0 ? levels[childLevel - firstLevel].width : width - 1;
+    int gridDepth = childLevel > 0 ? levels[childLevel - firstLevel].depth : depth - 1;
+    int x0 = blockX * perBlock, x1 = std::min(x0 + perBlock, gridWidth);
+    int z0 = blockZ * perBlock, z1 = std::min(z0 + perBlock, gridDepth);
+    float childSize = cellSize * (1 << childLevel);
+
+    //find the child cell the ray enters the block in
+    vec3 start = ray.origin + ray.direction * tMin;
+    int x = std::min(std::max((int)floorf((start.x - origin.x) / childSize), x0), x1 - 1);
+    int z = std::min(std::max((int)floorf((start.z - origin.z) / childSize), z0), z1 - 1);
+
+    //2D DDA through the children in front to back order
+    int stepX = ray.direction.x > 0.0f ? 1 : -1, stepZ = ray.direction.z > 0.0f ? 1 : -1;
+    float nextX = ray.direction.x != 0.0f ? (origin.x + (x + (stepX > 0)) * childSize - ray.origin.x) * ray.invDirection.x : FLT_MAX;
+    float nextZ = ray.direction.z != 0.0f ? (origin.z + (z + (stepZ > 0)) * childSize - ray.origin.z) * ray.invDirection.z : FLT_MAX;
+    float deltaX = fabsf(childSize * ray.invDirection.x), deltaZ = fabsf(childSize * ray.invDirection.z);
+
+    float t0 = tMin;
+    while (true)
+    {
+        float t1 = std::min(std::min(nextX, nextZ), tMax);
+
+        //skip children whose height range the ray passes entirely above or below
+        float y0 = ray.origin.y + ray.direction.y * t0, y1 = ray.origin.y + ray.direction.y * t1;
+        Range r = CellRange(childLevel, x, z);
+        if (std::max(y0, y1) >= r.min - 0.0001f && std::min(y0, y1) <= r.max + 0.0001f)
+        {
+            if (childLevel == 0 ? RaycastCell(ray, x, z, intersection) : Traverse(ray, childLevel, x, z, t0, t1, intersection))
+                return true;
+        }
+
+        if (t1 >= tMax)
+            return false;
+
+        if (nextX < nextZ)
+        {
+            x += stepX;
+            if (x < x0 || x >= x1)
+                return false;
+            t0 = nextX;
+            nextX += deltaX;
+        }
+        else
+        {
+            z += stepZ;
+            if (z < z0 || z >= z1)
+                return false;
+            t0 = nextZ;
+            nextZ += deltaZ;
+        }
+    }
+}
+
+bool Heightfield::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    if (levels.empty())
+        return false;
+
+    //clip the ray to the bounds of the whole field
+    vec3 t0 = (boundsMin - ray.origin) * ray.invDirection;
+    vec3 t1 = (boundsMax - ray.origin) * ray.invDirection;
+    float tNear = std::max(t0.min(t1).maxComponent(), 0.0f);
+    float tFar = t0.max(t1).minComponent();
+    if (tNear > tFar)
+        return false;
+
+    return Traverse(ray, firstLevel + (int)levels.size() - 1, 0, 0, tNear, tFar, intersection);
+}
+
+vec3 Heightfield::GetNormal(const vec3& pos, uint64_t element)
+{
+    float fx = (pos.x - origin.x) / cellSize, fz = (pos.z - origin.z) / cellSize;
+    int x = std::min(std::max((int)floorf(fx), 0), width - 2);
+    int z = std::min(std::max((int)floorf(fz), 0), depth - 2);
+    fx -= x;
+    fz -= z;
+
+    vec3 p00(0.0f, Height(x, z), 0.0f);
+    vec3 p11(cellSize, Height(x+1, z+1), cellSize);
+    if (fx >= fz)
+        return (p11 - p00).cross(vec3(cellSize, Height(x+1, z), 0.0f) - p00).normalize();
+    return (vec3(0.0f, Height(x, z+1), cellSize) - p00).cross(p11 - p00).normalize();
+}
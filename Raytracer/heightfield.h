@@ -0,0 +1,75 @@
+//
+//  heightfield.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__heightfield__
+#define __Raytracer__heightfield__
+
+#include "primitives.h"
+#include <vector>
+
+//a regular grid of height samples in the xz plane, each cell made of two triangles.
+//Rays walk a min/max pyramid over the grid with a 2D DDA per level, only descending
+//into blocks whose height range overlaps the ray, so the triangles are never stored.
+struct Heightfield : Primitive
+{
+    //width x depth samples in world units, sample (x,z) is at origin + (x*cellSize, height, z*cellSize).
+    //Fewer than 2 x 2 samples, a cell size that isn't finite and positive or too few heights are reported on stderr
+    //and give an empty field that nothing hits.
+    Heightfield(vec3 origin, float cellSize, int width, int depth, std::vector<float> heights);
+
+    virtual Primitive* Clone() const
+    {
+        return new Heightfield(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        bounds = AABB(boundsMin, boundsMax);
+        return true;
+    }
+
+    //bytes used by the samples and the pyramid.
+    size_t MemoryUsage() const;
+
+private:
+    //the pyramid starts with blocks of 1 << firstLevel cells a side, finer levels are
+    //computed from the samples on the fly to keep memory close to 4 bytes per sample.
+    static const int firstLevel = 2;
+
+    struct Range
+    {
+        float min, max;
+    };
+
+    struct Level
+    {
+        int width, depth;
+        std::vector<Range> ranges;
+    };
+
+    vec3 origin;
+    float cellSize;
+    int width, depth;
+    std::vector<float> heights;
+    std::vector<Level> levels;//levels[i] holds blocks of 1 << (firstLevel + i) cells
+    vec3 boundsMin, boundsMax;
+
+    float Height(int x, int z) const
+    {
+        return heights[(size_t)z * width + x];
+    }
+
+    Range CellRange(int level, int x, int z) const;
+    bool RaycastCell(const Ray& ray, int x, int z, float& intersection) const;
+    bool Traverse(const Ray& ray, int level, int blockX, int blockZ, float tMin, float tMax, float& intersection) const;
+};
+
+#endif /* defined(__Raytracer__heightfield__) */
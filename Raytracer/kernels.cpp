@@ -0,0 +1,233 @@
+//
+//  kernels.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "kernels.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+//each level only needs its own instructions, the rest of the program is still built for the baseline.
+//GCC would fuse the multiplies and adds into FMAs on levels that have them, changing the results.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace scalar
+{
+#define KERNEL
+    typedef float lane;
+    typedef bool mask;
+    static const int lanes = 1;
+
+    static inline lane load(const float* p) { return *p; }
+    static inline void store(float* p, lane a) { *p = a; }
+    static inline lane set1(float f) { return f; }
+    static inline lane add(lane a, lane b) { return a + b; }
+    static inline lane sub(lane a, lane b) { return a - b; }
+    static inline lane mul(lane a, lane b) { return a * b; }
+    static inline lane div(lane a, lane b) { return a / b; }
+    static inline lane min(lane a, lane b) { return a < b ? a : b; }
+    static inline lane max(lane a, lane b) { return a > b ? a : b; }
+    static inline lane sqrt(lane a) { return sqrtf(a); }
+    static inline mask cmple(lane a, lane b) { return a <= b; }
+    static inline mask cmpge(lane a, lane b) { return a >= b; }
+    static inline mask cmpgt(lane a, lane b) { return a > b; }
+    static inline mask andmask(mask a, mask b) { return a && b; }
+    static inline mask ormask(mask a, mask b) { return a || b; }
+    static inline int bits(mask a) { return a ? 1 : 0; }
+    static inline void toindices(uint32_t* indices, lane a) { *indices = (uint32_t)a; }
+
+#include "kernels.inl"
+#undef KERNEL
+}
+
+#ifdef KERNELS_X86
+namespace sse42
+{
+#define KERNEL __attribute__((target("sse4.2")))
+    typedef __m128 lane;
+    typedef __m128 mask;
+    static const int lanes = 4;
+
+    KERNEL static inline lane load(const float* p) { return _mm_loadu_ps(p); }
+    KERNEL static inline void store(float* p, lane a) { _mm_storeu_ps(p, a); }
+    KERNEL static inline lane set1(float f) { return _mm_set1_ps(f); }
+    KERNEL static inline lane add(lane a, lane b) { return _mm_add_ps(a, b); }
+    KERNEL static inline lane sub(lane a, lane b) { return _mm_sub_ps(a, b); }
+    KERNEL static inline lane mul(lane a, lane b) { return _mm_mul_ps(a, b); }
+    KERNEL static inline lane div(lane a, lane b) { return _mm_div_ps(a, b); }
+    KERNEL static inline lane min(lane a, lane b) { return _mm_min_ps(a, b); }
+    KERNEL static inline lane max(lane a, lane b) { return _mm_max_ps(a, b); }
+    KERNEL static inline lane sqrt(lane a) { return _mm_sqrt_ps(a); }
+    KERNEL static inline mask cmple(lane a, lane b) { return _mm_cmple_ps(a, b); }
+    KERNEL static inline mask cmpge(lane a, lane b) { return _mm_cmpge_ps(a, b); }
+    KERNEL static inline mask cmpgt(lane a, lane b) { return _mm_cmpgt_ps(a, b); }
+    KERNEL static inline mask andmask(mask a, mask b) { return _mm_and_ps(a, b); }
+    KERNEL static inline mask ormask(mask a, mask b) { return _mm_or_ps(a, b); }
+    KERNEL static inline int bits(mask a) { return _mm_movemask_ps(a); }
+    KERNEL static inline void toindices(uint32_t* indices, lane a) { _mm_storeu_si128((__m128i*)indices, _mm_cvttps_epi32(a)); }
+
+#include "kernels.inl"
+#undef KERNEL
+}
+
+namespace avx2
+{
+#define KERNEL __attribute__((target("avx2")))
+    typedef __m256 lane;
+    typedef __m256 mask;
+    static const int lanes = 8;
+
+    KERNEL static inline lane load(const float* p) { return _mm256_loadu_ps(p); }
+    KERNEL static inline void store(float* p, lane a) { _mm256_storeu_ps(p, a); }
+    KERNEL static inline lane set1(float f) { return _mm256_set1_ps(f); }
+    KERNEL static inline lane add(lane a, lane b) { return _mm256_add_ps(a, b); }
+    KERNEL static inline lane sub(lane a, lane b) { return _mm256_sub_ps(a, b); }
+    KERNEL static inline lane mul(lane a, lane b) { return _mm256_mul_ps(a, b); }
+    KERNEL static inline lane div(lane a, lane b) { return _mm256_div_ps(a, b); }
+    KERNEL static inline lane min(lane a, lane b) { return _mm256_min_ps(a, b); }
+    KERNEL static inline lane max(lane a, lane b) { return _mm256_max_ps(a, b); }
+    KERNEL static inline lane sqrt(lane a) { return _mm256_sqrt_ps(a); }
+    KERNEL static inline mask cmple(lane a, lane b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    KERNEL static inline mask cmpge(lane a, lane b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    KERNEL static inline mask cmpgt(lane a, lane b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    KERNEL static inline mask andmask(mask a, mask b) { return _mm256_and_ps(a, b); }
+    KERNEL static inline mask ormask(mask a, mask b) { return _mm256_or_ps(a, b); }
+    KERNEL static inline int bits(mask a) { return _mm256_movemask_ps(a); }
+    KERNEL static inline void toindices(uint32_t* indices, lane a) { _mm256_storeu_si256((__m256i*)indices, _mm256_cvttps_epi32(a)); }
+
+#include "kernels.inl"
+#undef KERNEL
+}
+
+//the same width as avx2, but compares go straight into mask registers. Widening to 512 bits would
+//need sixteen ray packets.
+namespace avx512vl
+{
+#define KERNEL __attribute__((target("avx512f,avx512vl")))
+    typedef __m256 lane;
+    typedef __mmask8 mask;
+    static const int lanes = 8;
+
+    KERNEL static inline lane load(const float* p) { return _mm256_loadu_ps(p); }
+    KERNEL static inline void store(float* p, lane a) { _mm256_storeu_ps(p, a); }
+    KERNEL static inline lane set1(float f) { return _mm256_set1_ps(f); }
+    KERNEL static inline lane add(lane a, lane b) { return _mm256_add_ps(a, b); }
+    KERNEL static inline lane sub(lane a, lane b) { return _mm256_sub_ps(a, b); }
+    KERNEL static inline lane mul(lane a, lane b) { return _mm256_mul_ps(a, b); }
+    KERNEL static inline lane div(lane a, lane b) { return _mm256_div_ps(a, b); }
+    KERNEL static inline lane min(lane a, lane b) { return _mm256_min_ps(a, b); }
+    KERNEL static inline lane max(lane a, lane b) { return _mm256_max_ps(a, b); }
+    KERNEL static inline lane sqrt(lane a) { return _mm256_sqrt_ps(a); }
+    KERNEL static inline mask cmple(lane a, lane b) { return _mm256_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    KERNEL static inline mask cmpge(lane a, lane b) { return _mm256_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    KERNEL static inline mask cmpgt(lane a, lane b) { return _mm256_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    KERNEL static inline mask andmask(mask a, mask b) { return a & b; }
+    KERNEL static inline mask ormask(mask a, mask b) { return a | b; }
+    KERNEL static inline int bits(mask a) { return a; }
+    KERNEL static inline void toindices(uint32_t* indices, lane a) { _mm256_storeu_si256((__m256i*)indices, _mm256_cvttps_epi32(a)); }
+
+#include "kernels.inl"
+#undef KERNEL
+}
+#endif
+
+//constant initialised, so any code running before main can already use it
+#ifdef KERNELS_X86
+static const PacketKernels levels[KernelLevelCount] =
+{
+    { scalar::mesh<uint32_t>, scalar::mesh<uint64_t>, scalar::quantize },
+    { sse42::mesh<uint32_t>, sse42::mesh<uint64_t>, sse42::quantize },
+    { avx2::mesh<uint32_t>, avx2::mesh<uint64_t>, avx2::quantize },
+    { avx512vl::mesh<uint32_t>, avx512vl::mesh<uint64_t>, avx512vl::quantize },
+};
+#else
+static const PacketKernels levels[KernelLevelCount] =
+{
+    { scalar::mesh<uint32_t>, scalar::mesh<uint64_t>, scalar::quantize },
+};
+#endif
+
+static const char* levelNames[KernelLevelCount] = { "scalar", "sse4.2", "avx2", "avx512vl" };
+
+KernelLevel detectkernellevel()
+{
+#ifdef KERNELS_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_2))
+        return KernelScalar;
+
+    //the wider registers also need the OS to save them on a context switch
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX) || __get_cpuid_max(0, nullptr) < 7)
+        return KernelSSE42;
+    uint32_t xcr0Low, xcr0High;
+    __asm__ ("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    if ((xcr0Low & 0x6) != 0x6)
+        return KernelSSE42;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (!(ebx & bit_AVX2))
+        return KernelSSE42;
+    if ((ebx & bit_AVX512F) && (ebx & bit_AVX512VL) && (xcr0Low & 0xe6) == 0xe6)
+        return KernelAVX512VL;
+    return KernelAVX2;
+#else
+    return KernelScalar;
+#endif
+}
+
+//detected the first time it's needed rather than at static initialisation, which other files' static
+//initialisers might run before
+static KernelLevel& currentlevel()
+{
+    static KernelLevel level = detectkernellevel();
+    return level;
+}
+
+const PacketKernels& packetkernels()
+{
+    return levels[currentlevel()];
+}
+
+KernelLevel kernellevel()
+{
+    return currentlevel();
+}
+
+bool setkernellevel(KernelLevel level)
+{
+    if (level > detectkernellevel())
+        return false;
+
+    currentlevel() = level;
+    return true;
+}
+
+bool findkernellevel(const char* name, KernelLevel& level)
+{
+    for (int i = 0; i<KernelLevelCount; i++)
+    {
+        if (strcmp(levelNames[i], name) == 0)
+        {
+            level = (KernelLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* kernellevelname(KernelLevel level)
+{
+    return levelNames[level];
+}
@@ -0,0 +1,75 @@
+//
+//  kernels.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__kernels__
+#define __Raytracer__kernels__
+
+#include "maths.h"
+#include <stddef.h>
+#include <stdint.h>
+
+//The hot packet kernels are built once per instruction set level and picked at startup from what
+//cpuid says the machine supports, so one binary runs the widest path each machine has. Every level
+//does the same float operations in the same order, so they all give the same images.
+//Each kernel does a whole traversal or a whole row of work per call, so the cost of calling through
+//the table is paid once per packet rather than once per primitive. Single primitives are tested with
+//the inline floatx8 code in primitives.h instead.
+enum KernelLevel
+{
+    KernelScalar,
+    KernelSSE42,
+    KernelAVX2,
+    //eight lanes like avx2, but with compares going straight into mask registers
+    KernelAVX512VL,
+    KernelLevelCount
+};
+
+//a mesh's hierarchy and faces, laid out as IndexedMesh and BasicBVH keep them
+template<typename Index>
+struct PacketMesh
+{
+    //the same layout as BasicBVH<Index>::Node
+    struct Node
+    {
+        vec3 min, max;
+        Index first, count;
+    };
+
+    const Node* nodes;
+    const vec3* vertices;
+    //stride per face, in leaf order. With a stride of 4 a face is a quad unless its last corner repeats its first.
+    const Index* indices;
+    int stride;
+};
+
+//rays are laid out as RayPacket::Floats, nine arrays of eight floats.
+struct PacketKernels
+{
+    //traces the packet through the mesh, nearest child along lane 0 first. Lanes keep their nearest
+    //hit in tMax, which starts as how far they may go, and the face hit in elements. Returns the
+    //lanes hit.
+    int (*mesh)(const float* rays, const PacketMesh<uint32_t>& mesh, float* tMax, uint64_t* elements);
+    int (*largeMesh)(const float* rays, const PacketMesh<uint64_t>& mesh, float* tMax, uint64_t* elements);
+    //clamps count floats to 0-1 and rounds them to integers from 0 to scale, NaN giving 0
+    void (*quantize)(const float* values, float scale, uint32_t* indices, size_t count);
+};
+
+//the kernels of the current level
+const PacketKernels& packetkernels();
+
+//the widest level this machine supports
+KernelLevel detectkernellevel();
+//the level packetkernels is currently set to
+KernelLevel kernellevel();
+//switches packetkernels to a level, false if the machine doesn't support it
+bool setkernellevel(KernelLevel level);
+//looks a level up by name, false if there isn't one called that
+bool findkernellevel(const char* name, KernelLevel& level);
+const char* kernellevelname(KernelLevel level);
+
+#endif /* defined(__Raytracer__kernels__) */
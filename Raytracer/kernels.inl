@@ -0,0 +1,139 @@
+//
+//  kernels.inl
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+//The bodies of the PacketKernels, included by kernels.cpp once for each level inside a namespace
+//that defines lane (the register type), mask, lanes (floats per register), KERNEL (the target
+//attribute) and the load, store, arithmetic, compare and toindices helpers for that level.
+//The triangle and box tests follow the floatx8 versions in primitives.h step for step, and are
+//inlined into the traversal built for the same level.
+
+KERNEL static int triangle(const float* rays, const vec3& v1, const vec3& e1, const vec3& e2, float* intersection)
+{
+    int hits = 0;
+    for (int i = 0; i<8; i+=lanes)
+    {
+        lane dx = load(rays + 24 + i), dy = load(rays + 32 + i), dz = load(rays + 40 + i);
+        lane e1x = set1(e1.x), e1y = set1(e1.y), e1z = set1(e1.z);
+        lane e2x = set1(e2.x), e2y = set1(e2.y), e2z = set1(e2.z);
+
+        //P = direction x e2
+        lane px = sub(mul(dy, e2z), mul(dz, e2y)), py = sub(mul(dz, e2x), mul(dx, e2z)), pz = sub(mul(dx, e2y), mul(dy, e2x));
+        lane det = add(add(mul(e1x, px), mul(e1y, py)), mul(e1z, pz));
+        mask hit = ormask(cmple(det, set1(-0.0001f)), cmpge(det, set1(0.0001f)));
+        lane invdet = div(set1(1.0f), det);
+
+        lane tx = sub(load(rays + i), set1(v1.x)), ty = sub(load(rays + 8 + i), set1(v1.y)), tz = sub(load(rays + 16 + i), set1(v1.z));
+        lane u = mul(add(add(mul(tx, px), mul(ty, py)), mul(tz, pz)), invdet);
+        hit = andmask(hit, andmask(cmpge(u, set1(0.0f)), cmple(u, set1(1.0f))));
+
+        //Q = T x e1
+        lane qx = sub(mul(ty, e1z), mul(tz, e1y)), qy = sub(mul(tz, e1x), mul(tx, e1z)), qz = sub(mul(tx, e1y), mul(ty, e1x));
+        lane v = mul(add(add(mul(dx, qx), mul(dy, qy)), mul(dz, qz)), invdet);
+        hit = andmask(hit, andmask(cmpge(v, set1(0.0f)), cmple(add(u, v), set1(1.0f))));
+
+        lane t = mul(add(add(mul(e2x, qx), mul(e2y, qy)), mul(e2z, qz)), invdet);
+        store(intersection + i, t);
+        hits |= bits(andmask(hit, cmpgt(t, set1(0.0001f)))) << i;
+    }
+    return hits;
+}
+
+KERNEL static int box(const float* rays, const vec3& boxMin, const vec3& boxMax, const float* tMax, float* tEnter)
+{
+    int hits = 0;
+    for (int i = 0; i<8; i+=lanes)
+    {
+        lane ox = load(rays + i), oy = load(rays + 8 + i), oz = load(rays + 16 + i);
+        lane ix = load(rays + 48 + i), iy = load(rays + 56 + i), iz = load(rays + 64 + i);
+        lane t0x = mul(sub(set1(boxMin.x), ox), ix), t0y = mul(sub(set1(boxMin.y), oy), iy), t0z = mul(sub(set1(boxMin.z), oz), iz);
+        lane t1x = mul(sub(set1(boxMax.x), ox), ix), t1y = mul(sub(set1(boxMax.y), oy), iy), t1z = mul(sub(set1(boxMax.z), oz), iz);
+        lane tNear = max(max(min(t0x, t1x), min(t0y, t1y)), min(t0z, t1z));
+        lane tFar = min(min(max(t0x, t1x), max(t0y, t1y)), max(t0z, t1z));
+        lane enter = max(tNear, set1(0.0f));
+        store(tEnter + i, enter);
+        hits |= bits(cmple(enter, min(tFar, load(tMax + i)))) << i;
+    }
+    return hits;
+}
+
+template<typename Index>
+KERNEL static int mesh(const float* rays, const PacketMesh<Index>& mesh, float* tMax, uint64_t* elements)
+{
+    int hits = 0;
+    vec3 direction(rays[24], rays[32], rays[40]);
+    Index stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const typename PacketMesh<Index>::Node& node = mesh.nodes[stack[--stackSize]];
+        float tEnter[8];
+        if (!box(rays, node.min, node.max, tMax, tEnter))
+            continue;
+
+        if (node.count == 0)
+        {
+            //push the child further along the first lane's direction first
+            const typename PacketMesh<Index>::Node& left = mesh.nodes[node.first];
+            const typename PacketMesh<Index>::Node& right = mesh.nodes[node.first + 1];
+            bool leftFirst = ((left.min + left.max) * 0.5f).dot(direction) <= ((right.min + right.max) * 0.5f).dot(direction);
+            stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+            stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+            continue;
+        }
+
+        for (Index i = node.first; i<node.first + node.count; i++)
+        {
+            const Index* face = mesh.indices + (size_t)i * mesh.stride;
+            const vec3& v1 = mesh.vertices[face[0]];
+            vec3 diagonal = mesh.vertices[face[2]] - v1;
+            float t[8];
+            int faceHits = triangle(rays, v1, mesh.vertices[face[1]] - v1, diagonal, t);
+            if (mesh.stride == 4 && face[3] != face[0])
+            {
+                //quads are tested as their two halves, which don't overlap, so a lane can only hit the
+                //second where it missed the first
+                float secondT[8];
+                int secondHits = triangle(rays, v1, diagonal, mesh.vertices[face[3]] - v1, secondT);
+                for (int bits = secondHits; bits; bits &= bits - 1)
+                    t[__builtin_ctz(bits)] = secondT[__builtin_ctz(bits)];
+                faceHits |= secondHits;
+            }
+
+            for (int bits = faceHits; bits; bits &= bits - 1)
+            {
+                int lane = __builtin_ctz(bits);
+                if (t[lane] < tMax[lane])
+                {
+                    tMax[lane] = t[lane];
+                    elements[lane] = i;
+                    hits |= 1 << lane;
+                }
+            }
+        }
+    }
+    return hits;
+}
+
+KERNEL static void quantize(const float* values, float scale, uint32_t* indices, size_t count)
+{
+    size_t i = 0;
+    for (; i + lanes <= count; i+=lanes)
+    {
+        //max picks 0 for NaN
+        lane c = min(max(load(values + i), set1(0.0f)), set1(1.0f));
+        toindices(indices + i, add(mul(c, set1(scale)), set1(0.5f)));
+    }
+    for (; i<count; i++)
+    {
+        float c = values[i];
+        c = c > 0.0f ? (c < 1.0f ? c : 1.0f) : 0.0f;
+        indices[i] = (uint32_t)(c * scale + 0.5f);
+    }
+}
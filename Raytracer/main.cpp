@@ -12,230 +12,546 @@
 #include <vector>
 #include <float.h>
 #include "objloader.h"
+#include "mesh.h"
+#include "primitives.h"
+#include "benchmark.h"
+#include "wavefront.h"
+#include "kernels.h"
+#include "fastmaths.h"
+#include "framebuffer.h"
+#include "camera.h"
+#include "threadpool.h"
+#include "scheduler.h"
+#include "numatopology.h"
+#include "pixelorder.h"
+#include "sampling.h"
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 color* image;
+//the colours the renderers write, converted into image a tile at a time as each one finishes
+std::vector<vec3> radiance;
+//tiles are converted into here first, each into its own part so no lock is needed, then copied into
+//image, which draw uploads from
+static color* converted;
+//the tiles of image that have changed since draw last uploaded them. displayLock covers both, so
+//draw never uploads a tile that's halfway through being copied.
+static std::mutex displayLock;
+static std::vector<Tile> dirtyTiles;
+//builds and renders the scene in the background so the window keeps drawing while it works
+static std::thread renderThread;
+static std::atomic<bool> stopRendering(false);
+//-linear and -dither change how radiance is converted
+static PixelFormat pixelFormat;
 
-static const int imageWidth = 800, imageHeight = 600, maxDepth = 3;
+static const int maxDepth = 3;
+//set by -size WxH
+static int imageWidth = 800, imageHeight = 600;
+//-threads N sets the size of the task pool everything runs on
+static int threadCount = 0;
+//set by -scaling, renders with 1 up to threadCount threads and prints the speedup
+static bool measureScaling = false;
+//plans the tiles of each frame from the last one's timings, starting from tileSize tiles
+//that can be split down to minTileSize. There are no timings for the first frame, so only
+//later frames, from -frames or -scaling's repeated renders, get planned tiles.
+static TileScheduler* scheduler;
+static const int tileSize = 32, minTileSize = 8;
+//set by -schedule, compares frames rendered with uniform and planned tiles
+static bool measureScheduling = false;
+//set by -numa, pins the pool's workers and moves radiance's rows to the nodes that render them.
+//-numa replicate also gives each node its own copy of the scene in sceneReplicas. Every frame is
+//rendered with uniform tiles under -numa, so scheduler's plans go unused: radiance is placed
+//knowing which node renders each uniform tile, and planned tiles would land on other nodes.
+static bool numa = false, replicateScene = false;
+//set by -order, the order tiles are dealt out in and the order each tile's packets are traced in
+static PixelOrder pixelOrder = OrderScanline;
+//set by -samples N, the jittered samples each pixel gets a frame, and -frames N, how many frames are
+//rendered and averaged. Without either every pixel gets one ray through its centre.
+static int samplesPerPixel = 1, frameCount = 1;
+//the frame being rendered, which seeds its samples, and the average of the frames rendered so far
+static int frameIndex = 0;
+static std::vector<vec3> accumulated;
 
-struct Ray
+static bool sampling()
 {
-    vec3 origin, direction;
+    return samplesPerPixel > 1 || frameCount > 1;
+}
+
+std::vector<Primitive*> scene;
+//set by -model file.obj, models added to the scene as meshes, in the order they're given
+static std::vector<const char*> modelFiles;
+static std::vector<std::vector<Primitive*>> sceneReplicas;
+
+//set by -wavefront, renders with the ray queues in wavefront.h instead of tile by tile
+static bool useWavefront = false;
+//set by -checkfastmath, renders with exact and fast maths and prints how far apart the images are
+static bool checkFastMath = false;
+
+vec3 raytrace(const std::vector<Primitive*>& scene, const Ray& r, int depth);
+
+//lights the point pos with normal N on a material, tracing shadow and reflection rays. Which features
+//the material has and its specular exponent are template parameters, so each combination compiles to
+//its own loop with no per light checks of the material. An exponent of 0 reads it from the material.
+template<bool hasDiffuse, bool hasSpec, unsigned int shininess, bool hasReflect>
+vec3 shadematerial(const std::vector<Primitive*>& scene, const Ray& r, const Material& material, const vec3& pos, const vec3& N, int depth)
+{
+    vec3 col;
+    for (auto iter = scene.begin(); iter != scene.end(); iter++)
+    {
+        Primitive* p = *iter;
+        if (p->isLight)
+        {
+            float shade = 1.0f;
+            
+            //Shadows
+            vec3 L = shadenormalize(((Sphere*)p)->pos - pos);
+            Ray shadowRay(pos + L * 0.01f, L);
+            float shadowIntersection;
+            uint64_t shadowElement;
+            for (auto iter = scene.begin(); iter != scene.end(); iter++)
+            {
+                if (!(*iter)->isLight && (*iter)->Raycast(shadowRay, shadowIntersection, shadowElement))
+                {
+                    shade = 0.0f;
+                    break;
+                }
+            }
+            
+            //N dot L diffuse lighting
+            if (hasDiffuse)
+            {
+                float diffuse = N.dot(L) * material.diffuse;
+                col += (p->material.color * material.color * diffuse) * shade;
+            }
+            
+            //specular component
+            if (hasSpec)
+            {
+                vec3 R = L - N * L.dot(N) * 2.0f;
+                float dot = r.direction.dot(R);
+                if (dot > 0.0f)
+                {
+                    float highlight = shininess ? shadepow<shininess>(dot) : shadepow(dot, material.shininess);
+                    col += p->material.color * material.color * highlight * material.spec * shade;
+                }
+            }
+        }
+    }
     
-    Ray(vec3 origin, vec3 direction) : origin(origin), direction(direction)
+    if (hasReflect && depth < maxDepth)
     {
+        vec3 R = r.direction - N * 2.0f * r.direction.dot(N);
+        vec3 reflectCol = raytrace(scene, Ray(pos, R), depth+1);
+        col += reflectCol * material.color * material.reflect;
     }
-};
-
-struct Material
-{
-    float reflect, diffuse, spec;
-    vec3 color;
     
-    Material() : reflect(0.0f), diffuse(1.0f), spec(1.0f), color(vec3(1.0f,1.0f,1.0f))
-    { }
-};
+    return col;
+}
+
+typedef vec3 (*MaterialShader)(const std::vector<Primitive*>& scene, const Ray& r, const Material& material, const vec3& pos, const vec3& N, int depth);
 
-struct Primitive
+//the eight feature combinations for one specular exponent, indexed by materialclass. Those without
+//specular don't care about the exponent and share the exponent 0 versions.
+#define MATERIAL_SHADERS(shininess) \
+    shadematerial<false, false, 0, false>, shadematerial<true, false, 0, false>, \
+    shadematerial<false, true, shininess, false>, shadematerial<true, true, shininess, false>, \
+    shadematerial<false, false, 0, true>, shadematerial<true, false, 0, true>, \
+    shadematerial<false, true, shininess, true>, shadematerial<true, true, shininess, true>
+
+//specular exponents with their own shaders, any others read theirs from the material
+static const unsigned int shaderShininess[] = { 0, 10, 20, 50 };
+static const MaterialShader materialShaders[] =
 {
-    Material material;
-    const char* name;
-    bool isLight = false;
-    
-    virtual bool Raycast(const Ray& ray, float& intersection) = 0;
-    virtual vec3 GetNormal(const vec3& pos) = 0;
+    MATERIAL_SHADERS(0), MATERIAL_SHADERS(10), MATERIAL_SHADERS(20), MATERIAL_SHADERS(50)
 };
 
-struct Sphere : Primitive
+//the index into materialShaders for a material: a bit each for diffuse, specular and reflection,
+//plus eight times the shaderShininess slot of its exponent
+int materialclass(const Material& material)
 {
-    vec3 pos;
-    float radius, radiusSq;
-    
-    Sphere(vec3 pos, float radius) : pos(pos), radius(radius), radiusSq(radius*radius)
-    {}
-    
-    virtual bool Raycast(const Ray& ray, float& intersection)
+    int features = (material.diffuse > 0.0f ? 1 : 0) | (material.spec > 0.0f ? 2 : 0) | (material.reflect > 0.0f ? 4 : 0);
+    for (int slot = 1; slot<4; slot++)
     {
-        vec3 l = pos - ray.origin;//vector from sphere pos to ray origin
-        float distToCenter = l.dot(ray.direction);
-        if (distToCenter < 0.0f)//sphere behind ray
-            return false;
-        float distToIntersectSq = l.dot(l) - distToCenter * distToCenter;//pythagorous theorum to get intersection dist from sphere midpoint along ray
-        if (distToIntersectSq > radiusSq)
-            return false;
-        
-        intersection = distToCenter - sqrtf(radiusSq - distToIntersectSq);
-        return true;
+        if (material.shininess == shaderShininess[slot])
+            return slot * 8 + features;
     }
+    return features;
+}
+
+//lights the point where r hit nearestPrimitive, tracing shadow and reflection rays
+vec3 shade(const std::vector<Primitive*>& scene, const Ray& r, Primitive* nearestPrimitive, float nearestIntersection, uint64_t nearestElement, int depth)
+{
+    if (nearestPrimitive->isLight)
+        return nearestPrimitive->material.color;
     
-    virtual vec3 GetNormal(const vec3& pos)
-    {
-        return (pos - this->pos).normalize();
-    }
-};
+    vec3 pos = r.origin + r.direction * nearestIntersection;
+    vec3 N = nearestPrimitive->GetNormal(pos, nearestElement);
+    const Material& material = nearestPrimitive->material;
+    return materialShaders[materialclass(material)](scene, r, material, pos, N, depth);
+}
 
-struct Plane : Primitive
+vec3 raytrace(const std::vector<Primitive*>& scene, const Ray& r, int depth)
 {
-    vec3 normal;
-    float offset;
+    //find nearest intersection
+    float nearestIntersection = FLT_MAX, intersection;
+    uint64_t nearestElement = 0, element;
+    Primitive* nearestPrimitive = nullptr;
+    for (auto iter = scene.begin(); iter != scene.end(); iter++)
+    {
+        if ((*iter)->Raycast(r, intersection, element) && nearestIntersection > intersection)
+        {
+            nearestIntersection = intersection;
+            nearestElement = element;
+            nearestPrimitive = *iter;
+        }
+    }
     
-    Plane(vec3 normal, float offset) : normal(normal), offset(offset)
-    {}
+    //nothing hit, render BG color
+    if (!nearestPrimitive)
+        return vec3();
     
-    virtual bool Raycast(const Ray& ray, float& intersection)
+    return shade(scene, r, nearestPrimitive, nearestIntersection, nearestElement, depth);
+}
+
+Camera* camera;
+
+//finds what each lane of packet hits nearest, with the same search as raytrace across all eight lanes,
+//and shades the first count of them into colors
+static void tracepacket(const std::vector<Primitive*>& scene, const std::vector<Primitive*>& visible, const RayPacket& packet, int count, vec3* colors)
+{
+    floatx8 nearestIntersection(FLT_MAX), intersection;
+    uint64_t nearestElement[8] = {}, element[8];
+    Primitive* nearestPrimitive[8] = {};
+    for (Primitive* p : visible)
     {
-        float ldotn = normal.dot(ray.direction);
-        if (ldotn == 0.0f)
-            return false;
+        //intersection is only filled in by the call, so it must come before the compare
+        maskx8 hits = p->RaycastPacket(packet, intersection, element);
+        maskx8 closer = hits & (intersection < nearestIntersection);
+        if (closer.none())
+            continue;
         
-        intersection = (offset - normal.dot(ray.origin)) / ldotn;
-        return intersection > 0.0f;
+        nearestIntersection = floatx8::select(closer, intersection, nearestIntersection);
+        for (int bits = closer.bits(); bits; bits &= bits - 1)
+        {
+            int lane = __builtin_ctz(bits);
+            nearestElement[lane] = element[lane];
+            nearestPrimitive[lane] = p;
+        }
     }
     
-    virtual vec3 GetNormal(const vec3& pos)
-    {
-        return normal;
-    }
-};
+    for (int lane = 0; lane<count; lane++)
+        colors[lane] = nearestPrimitive[lane] ? shade(scene, packet.Lane(lane), nearestPrimitive[lane], nearestIntersection[lane], nearestElement[lane], 0) : vec3();
+}
 
-struct Triangle : Primitive
+//traces the primary rays of a tile of pixels as packets of eight along each row, only testing
+//the primitives whose bounds overlap the tile's frustum. Each pixel is then shaded on its own.
+//The packets are taken in pixelOrder.
+//
+//When sampling each pixel's samples are jittered by samplejitter and added up in sample order, so a
+//pixel's colour only depends on the pixel and frame, never on which tile or thread it was traced in.
+void tracetile(const std::vector<Primitive*>& scene, int tileX, int tileY, int tileWidth, int tileHeight)
 {
-    vec3 v1, e1, e2, N;
-    
-    Triangle(vec3 v1, vec3 v2, vec3 v3) : v1(v1), e1(v2-v1), e2(v3-v1)
+    int lastX = std::min(tileX + tileWidth, imageWidth) - 1, lastY = std::min(tileY + tileHeight, imageHeight) - 1;
+    //jittered rays can go anywhere in their pixels, so the frustum goes round the outer edges of the
+    //tile's pixels rather than through their centres
+    float margin = sampling() ? 0.5f : 0.0f;
+    vec3 corners[4] = {
+        camera->GetSampleRay(tileX - margin, tileY - margin).direction, camera->GetSampleRay(lastX + margin, tileY - margin).direction,
+        camera->GetSampleRay(lastX + margin, lastY + margin).direction, camera->GetSampleRay(tileX - margin, lastY + margin).direction
+    };
+    Frustum frustum(camera->position, corners);
+    
+    std::vector<Primitive*> visible;
+    visible.reserve(scene.size());
+    for (Primitive* p : scene)
     {
-        N = e1.cross(e2).normalize();
+        AABB bounds;
+        if (!p->GetBounds(bounds) || frustum.Overlaps(bounds))
+            visible.push_back(p);
     }
     
-    virtual bool Raycast(const Ray& ray, float& intersection)
+    std::vector<uint32_t> packets;
+    curveorder(pixelOrder, (lastX - tileX) / 8 + 1, lastY - tileY + 1, packets);
+    for (uint32_t cell : packets)
     {
-        vec3 P = ray.direction.cross(e2);
-        float det = e1.dot(P);
-        if (det > -0.0001f && det < 0.0001f)
-            return false;
-        float invdet = 1.0f/det;
-        
-        vec3 T = ray.origin - v1;
-        float u = T.dot(P) * invdet;
-        if (u < 0.0f || u > 1.0f)
-            return false;
-        
-        vec3 Q = T.cross(e1);
-        float v = ray.direction.dot(Q) * invdet;
-        if (v < 0.0f || u + v > 1.0f)
-            return false;
+        //each cell is a run of eight pixels along one of the tile's rows
+        int packetX = tileX + (cell & 0xffff) * 8, y = tileY + (cell >> 16);
+        //rays past the end of the row repeat the last column and are never written
+        int count = std::min(8, lastX - packetX + 1);
+        vec3* pixels = &radiance[y*imageWidth + packetX];
+        if (!sampling())
+        {
+            tracepacket(scene, visible, camera->GetPacket(packetX, y, count), count, pixels);
+            continue;
+        }
         
-        intersection = e2.dot(Q) * invdet;
-        return intersection > 0.0001f;
+        vec3 sum[8], colors[8];
+        for (int sample = 0; sample<samplesPerPixel; sample++)
+        {
+            float offsetX[8], offsetY[8];
+            for (int lane = 0; lane<8; lane++)
+                samplejitter(packetX + std::min(lane, count - 1), y, sample, frameIndex, offsetX[lane], offsetY[lane]);
+            tracepacket(scene, visible, camera->GetPacket(packetX, y, count, offsetX, offsetY), count, colors);
+            for (int lane = 0; lane<count; lane++)
+                sum[lane] += colors[lane];
+        }
+        for (int lane = 0; lane<count; lane++)
+            pixels[lane] = sum[lane] * (1.0f / samplesPerPixel);
     }
+}
+
+//folds a finished tile of radiance into accumulated when sampling, converts it and copies it into
+//image, queueing it for the next draw to upload. Only the copy is done holding displayLock.
+static void publishtile(int x, int y, int width, int height)
+{
+    width = std::min(width, imageWidth - x);
+    height = std::min(height, imageHeight - y);
     
-    virtual vec3 GetNormal(const vec3& pos)
+    const vec3* pixels = radiance.data();
+    if (sampling())
     {
-        return N;
+        //a running mean, each pixel updated from its own values in frame order, so the result is the
+        //same whichever tile and thread the pixel was traced in
+        float weight = 1.0f / (frameIndex + 1);
+        for (int row = y; row<y + height; row++)
+        {
+            for (int i = row*imageWidth + x; i<row*imageWidth + x + width; i++)
+                accumulated[i] += (radiance[i] - accumulated[i]) * weight;
+        }
+        pixels = accumulated.data();
     }
-};
+    
+    convertregion(pixels, imageWidth, x, y, width, height, pixelFormat, (unsigned char*)converted);
+    
+    std::lock_guard<std::mutex> guard(displayLock);
+    for (int row = y; row<y + height; row++)
+        memcpy(image + row*imageWidth + x, converted + row*imageWidth + x, width * sizeof(color));
+    dirtyTiles.push_back({ x, y, width, height, 0.0 });
+}
 
-std::vector<Primitive*> scene;
+//publishes a whole frame of radiance, converting it across the task pool and then swapping it in as
+//image, so draw is never kept waiting on the conversion. Only the wavefront renders whole frames, and
+//it doesn't sample, so there's nothing to accumulate.
+static void publishframe()
+{
+    convertpixels(radiance.data(), imageWidth, imageHeight, pixelFormat, (unsigned char*)converted);
+    
+    std::lock_guard<std::mutex> guard(displayLock);
+    std::swap(image, converted);
+    dirtyTiles.assign(1, { 0, 0, imageWidth, imageHeight, 0.0 });
+}
 
-float clamp01(float f)
+//renders the tiles scheduler plans across the task pool, timing each one for the next frame's plan,
+//and publishes each tile as it finishes unless only the timings are wanted. Returns how many tiles
+//there were.
+size_t tracetiles(bool uniform, bool publish = true)
 {
-    return f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+    std::vector<Tile>& tiles = scheduler->Plan(taskpool().ThreadCount(), uniform);
+    taskpool().Run((int)tiles.size(), [&tiles, publish](int i) {
+        if (stopRendering)
+            return;
+        
+        Tile& tile = tiles[i];
+        const std::vector<Primitive*>& nodeScene = sceneReplicas.empty() ? scene : sceneReplicas[ThreadPool::CurrentNode()];
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        tracetile(nodeScene, tile.x, tile.y, tile.width, tile.height);
+        tile.cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (publish)
+            publishtile(tile.x, tile.y, tile.width, tile.height);
+    });
+    scheduler->Finish();
+    return tiles.size();
 }
 
-vec3 raytrace(const Ray& r, int depth)
+//loads a model as a Mesh, keeping its quads whole, or as a LargeMesh if it has too many vertices or
+//faces for 32 bit indices. Returns null if it couldn't be loaded or has no faces, or if the program
+//is quitting, which is checked between parsing and building since either can take a while.
+static Primitive* loadmesh(const char* file)
 {
-    //find nearest intersection
-    float nearestIntersection = FLT_MAX, intersection;
-    Primitive* nearestPrimitive = nullptr;
-    for (auto iter = scene.begin(); iter != scene.end(); iter++)
+    std::vector<vec3> verts, normals;
+    std::vector<vec2> uvs;
+    std::vector<uint64_t> wideInds, wideQuadInds;
     {
-        if ((*iter)->Raycast(r, intersection) && nearestIntersection > intersection)
+        std::vector<int> inds, quadInds;
+        LoadResult result = LoadModel(file, verts, uvs, normals, inds, quadInds);
+        if (stopRendering || result == LoadFailed || (result == LoadSucceeded && inds.empty() && quadInds.empty()))
+            return nullptr;
+        //counting every quad as the two triangles it might be split into
+        if (result == LoadSucceeded && inds.size() / 3 + quadInds.size() / 2 <= BVH::MaxItems())
+            return new Mesh(verts, inds, quadInds);
+        
+        //small enough indices but too many faces for the 32 bit hierarchy
+        if (result == LoadSucceeded)
         {
-            nearestIntersection = intersection;
-            nearestPrimitive = *iter;
+            wideInds.assign(inds.begin(), inds.end());
+            wideQuadInds.assign(quadInds.begin(), quadInds.end());
         }
     }
     
-    //nothing hit, render BG color
-    if (!nearestPrimitive)
-        return vec3();
+    if (wideInds.empty() && wideQuadInds.empty())
+    {
+        if (LoadModel(file, verts, uvs, normals, wideInds, wideQuadInds) != LoadSucceeded || (wideInds.empty() && wideQuadInds.empty()))
+            return nullptr;
+    }
+    if (stopRendering)
+        return nullptr;
+    return new LargeMesh(verts, wideInds, wideQuadInds);
+}
+
+//loads each of modelFiles and builds its mesh as a task of its own, so one model's hierarchy can be
+//built while another is still being parsed
+static void loadmodels()
+{
+    std::vector<Primitive*> meshes(modelFiles.size());
+    TaskGroup group;
+    for (size_t i = 0; i<modelFiles.size(); i++)
+    {
+        group.Run([&meshes, i]() {
+            if (!stopRendering)
+                meshes[i] = loadmesh(modelFiles[i]);
+        });
+    }
+    group.Wait();
+    if (stopRendering)
+        return;
     
-    vec3 col;
-    vec3 pos = r.origin + r.direction * nearestIntersection;
-    vec3 N = nearestPrimitive->GetNormal(pos);
+    for (size_t i = 0; i<modelFiles.size(); i++)
+    {
+        if (meshes[i])
+            scene.push_back(meshes[i]);
+        else
+            fprintf(stderr, "%s: no faces loaded\n", modelFiles[i]);
+    }
+}
+
+//renders the next frame into radiance, tile by tile or as a wavefront, converting it into image as it
+//goes. When sampling, image shows the average of every frame so far.
+void renderimage()
+{
+    static_assert(sizeof(color) == 3, "image is written as RGB8");
+    if (sampling())
+        accumulated.resize(imageWidth*imageHeight);
     
-    if (nearestPrimitive->isLight)
-        col = nearestPrimitive->material.color;
+    if (useWavefront)
+    {
+        renderwavefront(scene, *camera, maxDepth, radiance);
+        publishframe();
+    }
     else
     {
-        for (auto iter = scene.begin(); iter != scene.end(); iter++)
+        //every tile writes its own pixels, so they can go straight into radiance without locking.
+        //-numa keeps to uniform tiles, planned ones are dealt longest first which would scatter each
+        //node's tiles over the image instead of keeping them in its rows.
+        radiance.resize(imageWidth*imageHeight);
+        tracetiles(numa);
+    }
+    frameIndex++;
+}
+
+//-numa moves each uniform tile's part of radiance to the node of the worker it's dealt to. Tiles are
+//dealt in contiguous runs, so each node's workers get neighbouring tiles, but pages shared by tiles of
+//different nodes end up on whichever is moved last.
+static void placeradiance()
+{
+    if (!numa)
+        return;
+    
+    radiance.resize(imageWidth*imageHeight);
+    std::vector<Tile>& tiles = scheduler->Plan(taskpool().ThreadCount(), true);
+    int count = (int)tiles.size(), workers = taskpool().ThreadCount();
+    for (int w = 0; w<workers; w++)
+    {
+        for (int i = count * w / workers; i < count * (w + 1) / workers; i++)
         {
-            Primitive* p = *iter;
-            if (p->isLight)
-            {
-                float shade = 1.0f;
-                
-                //Shadows
-                vec3 L = (((Sphere*)p)->pos - pos).normalize();
-                Ray shadowRay(pos + L * 0.01f, L);
-                float shadowIntersection;
-                for (auto iter = scene.begin(); iter != scene.end(); iter++)
-                {
-                    if (!(*iter)->isLight && (*iter)->Raycast(shadowRay, shadowIntersection))
-                    {
-                        shade = 0.0f;
-                        break;
-                    }
-                }
-                
-                //N dot L diffuse lighting
-                if (nearestPrimitive->material.diffuse > 0.0f)
-                {
-                    float diffuse = N.dot(L) * nearestPrimitive->material.diffuse;
-                    col += (p->material.color * nearestPrimitive->material.color * diffuse) * shade;
-                }
-                
-                //specular component
-                if (nearestPrimitive->material.spec > 0.0f)
-                {
-                    vec3 R = L - N * L.dot(N) * 2.0f;
-                    float dot = r.direction.dot(R);
-                    if (dot > 0.0f)
-                        col += p->material.color * nearestPrimitive->material.color * powf(dot, 20.0f) * nearestPrimitive->material.spec * shade;
-                }
-            }
+            const Tile& tile = tiles[i];
+            int width = std::min(tile.width, imageWidth - tile.x);
+            for (int y = tile.y; y < std::min(tile.y + tile.height, imageHeight); y++)
+                movetonode(&radiance[y*imageWidth + tile.x], width * sizeof(vec3), taskpool().WorkerNode(w));
         }
-        
-        if (nearestPrimitive->material.reflect > 0.0f && depth < maxDepth)
+    }
+}
+
+//copies the scene once per node, each copy made by a thread pinned to the node so its memory is
+//allocated there
+static void replicatescene()
+{
+    const NumaTopology& topology = numatopology();
+    sceneReplicas.resize(topology.NodeCount());
+    for (int node = 0; node<topology.NodeCount(); node++)
+    {
+        std::thread thread([&topology, node]() {
+            pinthread(topology.Cpus(node)[0]);
+            for (Primitive* p : scene)
+                sceneReplicas[node].push_back(p->Clone());
+        });
+        thread.join();
+    }
+}
+
+//renders the scene with 1, 2, 4 and so on up to the pool's thread count, printing the primary rays
+//per second of each against one thread. Each count takes the best of three renders.
+static void measurescaling()
+{
+    int maxThreads = taskpool().ThreadCount();
+    double single = 0.0;
+    printf("\n");
+    for (int threads = 1; threads <= maxThreads; threads = threads*2 > maxThreads && threads < maxThreads ? maxThreads : threads*2)
+    {
+        ThreadPool* full = settaskpool(new ThreadPool(threads, numa));
+        placeradiance();
+        double best = 1e30;
+        for (int i = 0; i<3; i++)
         {
-            vec3 R = r.direction - N * 2.0f * r.direction.dot(N);
-            vec3 reflectCol = raytrace(Ray(pos, R), depth+1);
-            col += reflectCol * nearestPrimitive->material.color * nearestPrimitive->material.reflect;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            renderimage();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
         }
+        delete settaskpool(full);
+        placeradiance();
+        
+        double mrays = imageWidth * imageHeight / (best * 1000000.0);
+        if (threads == 1)
+            single = mrays;
+        printf("%3d threads: %8.3f ms, %7.2f Mrays/s, %5.2fx\n", threads, best * 1000.0, mrays, mrays / single);
     }
-
-    return col;
 }
 
-void LoadModel(const char* model)
+//renders frames with uniform tiles and then with planned ones, each the best of three, and prints
+//their wall times and the makespans the measured tile times would give on the pool and on 64 threads.
+//The frames are only timed, image keeps the one rendered before. Under -numa the planned frames
+//write radiance placed for uniform tiles, so they show what planning would cost there.
+static void measurescheduling()
 {
-    std::vector<vec3> verts;
-    std::vector<vec2> uvs;
-    std::vector<vec3> normals;
-    std::vector<int> inds;
-    
-    LoadModel(model, verts, uvs, normals, inds);
-    
-    for (int i = 0; i<inds.size();i+=3)
+    printf("\n");
+    for (int uniform = 1; uniform >= 0; uniform--)
     {
-        scene.push_back(new Triangle(verts[inds[i]], verts[inds[i+1]], verts[inds[i+2]]));
+        double best = 1e30;
+        size_t tiles = 0;
+        for (int i = 0; i<3; i++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            tiles = tracetiles(uniform != 0, false);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        
+        //the last frame's tiles still hold their measured times. Tiles planned for 64 threads are split
+        //finer than for the pool, so that plan is simulated with the times the frame predicts for it.
+        int threads = taskpool().ThreadCount();
+        double makespan = scheduler->Makespan(threads);
+        double wideMakespan = uniform ? scheduler->Makespan(64) : (scheduler->Plan(64), scheduler->Makespan(64));
+        printf("%s tiles: %zu, %.3f ms, makespan %.3f ms on %d threads, %.3f ms on 64\n", uniform ? "uniform" : "planned", tiles, best * 1000.0, makespan * 1000.0, threads, wideMakespan * 1000.0);
     }
 }
 
-void setup()
+//builds the scene and renders it, on renderThread
+static void renderscene()
 {
-    texturerenderer_setup();
-    
-    clock_t start = clock();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     
     Sphere* s = new Sphere(vec3(0.0f, 0.0f, 0.0f), 2.5f);
     s->material.reflect = 1.0f;
@@ -254,40 +570,193 @@ void setup()
     
     scene.push_back(new Plane(vec3(0.0f, 1.0f, 0.0f), -4.0f));
     
-    //LoadModel("/Users/alex/repos/native/Raytracer/Raytracer/sponza.obj");
+    loadmodels();
+    if (stopRendering)
+        return;
     
-    image = new color[imageWidth*imageHeight];
+    //frames the scene the same way the old fixed camera did at 800x600
+    camera = new Camera(vec3(0.0f, 0.0f, -5.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f), 2.0f * atanf(0.6f), imageWidth, imageHeight);
+    scheduler = new TileScheduler(imageWidth, imageHeight, tileSize, minTileSize, pixelOrder);
+    placeradiance();
+    if (replicateScene)
+        replicatescene();
     
     printf("Rendering...\n");
-    for (int y = 0; y<imageHeight; y++)
+    if (checkFastMath)
     {
-        for (int x = 0; x<imageWidth; x++)
+        //both images are of the first frame, so they're sampled the same way
+        fastMath = false;
+        renderimage();
+        std::vector<color> exact(image, image + imageWidth*imageHeight);
+        fastMath = true;
+        frameIndex = 0;
+        renderimage();
+        
+        const unsigned char *a = (const unsigned char*)exact.data(), *b = (const unsigned char*)image;
+        int count = imageWidth*imageHeight*3, differing = 0, largest = 0;
+        for (int i = 0; i<count; i++)
         {
-            //compute camera ray
-            vec3 o(0.0f, 0.0f, -5.0f);
-            float offsetX = x * 0.01f - 4.0f;
-            float offsetY = y * 0.01f - 4.0f;
-            Ray r(o, (vec3(offsetX, offsetY, 0.0f) - o).normalize());
-
-            vec3 col = raytrace(r, 0);
-            image[(y*imageWidth)+x] = (color){ (char)(clamp01(col.x)*255.0f), (char)(clamp01(col.y)*255.0f), (char)(clamp01(col.z)*255.0f) };
+            int diff = abs(a[i] - b[i]);
+            differing += diff != 0;
+            largest = std::max(largest, diff);
         }
-        
-        printf("\r%d/%d            ", y, imageHeight);
+        printf("\rfast maths changed %d of %d channels, by at most %d\n", differing, count, largest);
+    }
+    else
+    {
+        for (int frame = 0; frame<frameCount && !stopRendering; frame++)
+            renderimage();
     }
     
-    printf("\rRender took %f seconds", ((clock()-start)/(double)CLOCKS_PER_SEC));
+    if (stopRendering)
+        return;
+    
+    //wall clock time, clock() would add up the CPU time of every thread
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("\rRender took %f seconds (%s kernels, %d threads, %s order%s%s)", seconds, kernellevelname(kernellevel()), taskpool().ThreadCount(), pixelordername(pixelOrder), fastMath ? ", fast maths" : "", numa ? (replicateScene ? ", NUMA with scene replicas" : ", NUMA") : "");
+    
+    if (measureScaling)
+        measurescaling();
+    if (measureScheduling)
+        measurescheduling();
+}
+
+//asks renderThread to stop once the tiles or models it's working on are done and waits for it, so it
+//isn't still using the scene when the program's globals are destroyed
+static void stoprendering()
+{
+    stopRendering = true;
+    if (renderThread.joinable())
+        renderThread.join();
+}
+
+void setup()
+{
+    texturerenderer_setup();
     
+    //the window starts black and fills in as the tiles are published
+    image = new color[imageWidth*imageHeight]();
+    converted = new color[imageWidth*imageHeight]();
     texturerenderer_displaytexture(image, imageWidth, imageHeight);
+    
+    renderThread = std::thread(renderscene);
+    atexit(stoprendering);
 }
 
+//uploads the tiles published since the last draw. Once they add up to the whole image, one upload of
+//all of it is cheaper than going tile by tile.
 void draw(float time)
 {
+    {
+        std::lock_guard<std::mutex> guard(displayLock);
+        size_t area = 0;
+        for (const Tile& tile : dirtyTiles)
+            area += tile.width * tile.height;
+        
+        if (area >= (size_t)imageWidth*imageHeight)
+            texturerenderer_updatetexture(image, imageWidth, 0, 0, imageWidth, imageHeight);
+        else
+        {
+            for (const Tile& tile : dirtyTiles)
+                texturerenderer_updatetexture(image, imageWidth, tile.x, tile.y, tile.width, tile.height);
+        }
+        dirtyTiles.clear();
+    }
+    
     texturerenderer_draw();
 }
 
 int main(int argc, char *argv[])
 {
+    //-cpu level forces the kernels to an instruction set level, for testing the narrower paths. It can
+    //go anywhere, so it's taken out before the rest are read.
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "-cpu") != 0)
+            continue;
+        
+        KernelLevel level;
+        if (!findkernellevel(argv[i + 1], level) || !setkernellevel(level))
+        {
+            fprintf(stderr, "-cpu: %s isn't a level this machine supports, the widest is %s\n", argv[i + 1], kernellevelname(detectkernellevel()));
+            return 1;
+        }
+        std::copy(argv + i + 2, argv + argc, argv + i);
+        argc -= 2;
+        i--;
+    }
+    
+    //-benchmark [name] runs the primitive benchmarks instead of opening a window
+    if (argc > 1 && strcmp(argv[1], "-benchmark") == 0)
+        return runbenchmarks(argc > 2 ? argv[2] : nullptr);
+    
+    for (int i = 1; i<argc; i++)
+    {
+        if (strcmp(argv[i], "-wavefront") == 0)
+            useWavefront = true;
+        else if (strcmp(argv[i], "-fastmath") == 0)
+            fastMath = true;
+        else if (strcmp(argv[i], "-checkfastmath") == 0)
+            checkFastMath = true;
+        else if (strcmp(argv[i], "-linear") == 0)
+            pixelFormat.srgb = false;
+        else if (strcmp(argv[i], "-dither") == 0)
+            pixelFormat.dither = true;
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-scaling") == 0)
+            measureScaling = true;
+        else if (strcmp(argv[i], "-schedule") == 0)
+            measureScheduling = true;
+        else if (strcmp(argv[i], "-numa") == 0)
+        {
+            numa = true;
+            if (i + 1 < argc && strcmp(argv[i + 1], "replicate") == 0)
+            {
+                replicateScene = true;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "-model") == 0 && i + 1 < argc)
+            modelFiles.push_back(argv[++i]);
+        else if (strcmp(argv[i], "-order") == 0 && i + 1 < argc)
+        {
+            if (!findpixelorder(argv[++i], pixelOrder))
+            {
+                fprintf(stderr, "-order: expected scanline, morton or hilbert, not %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if ((strcmp(argv[i], "-samples") == 0 || strcmp(argv[i], "-frames") == 0) && i + 1 < argc)
+        {
+            int& count = strcmp(argv[i], "-samples") == 0 ? samplesPerPixel : frameCount;
+            count = atoi(argv[i + 1]);
+            if (count <= 0)
+            {
+                fprintf(stderr, "%s: expected a count above 0, not %s\n", argv[i], argv[i + 1]);
+                return 1;
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &imageWidth, &imageHeight) != 2 || imageWidth <= 0 || imageHeight <= 0)
+            {
+                fprintf(stderr, "-size: expected WIDTHxHEIGHT, not %s\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+    
+    //the wavefront renderer only traces rays through the pixel centres
+    if (useWavefront && sampling())
+    {
+        fprintf(stderr, "-samples and -frames can't be used with -wavefront\n");
+        return 1;
+    }
+    
+    settaskpool(new ThreadPool(threadCount, numa));
+    
     return initglwt("Raytracer", imageWidth, imageHeight, false);
 }
 
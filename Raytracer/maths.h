@@ -27,6 +27,21 @@ inline float deg2rad(float deg)
     return (deg * M_PI) / 180.0f;
 }
 
+//fminf and fmaxf without the library call GCC makes for them: a NaN operand is ignored in favour
+//of the other one, which the slab tests rely on when 0 * inf gives NaN. b < a ? b : a already gives a
+//when b is NaN, so only a being NaN needs picking out. Compiles to minss/maxss and a conditional move.
+inline float minnum(float a, float b)
+{
+    float m = b < a ? b : a;
+    return a != a ? b : m;
+}
+
+inline float maxnum(float a, float b)
+{
+    float m = b > a ? b : a;
+    return a != a ? b : m;
+}
+
 //represents a 2D vector
 struct vec2
 {
@@ -170,6 +185,30 @@ struct vec3
                     x*other.y - y*other.x
                     );
     }
+
+    //returns the per component minimum of the two vectors.
+    inline vec3 min(const vec3& other) const
+    {
+        return vec3(minnum(x, other.x), minnum(y, other.y), minnum(z, other.z));
+    }
+
+    //returns the per component maximum of the two vectors.
+    inline vec3 max(const vec3& other) const
+    {
+        return vec3(maxnum(x, other.x), maxnum(y, other.y), maxnum(z, other.z));
+    }
+
+    //returns the smallest of the three components.
+    inline float minComponent() const
+    {
+        return minnum(x, minnum(y, z));
+    }
+
+    //returns the largest of the three components.
+    inline float maxComponent() const
+    {
+        return maxnum(x, maxnum(y, z));
+    }
 };
 
 //represents a 4x4 matrix
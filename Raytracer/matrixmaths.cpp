@@ -0,0 +1,179 @@
+//
+//  matrixmaths.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "matrixmaths.h"
+
+static_assert(sizeof(vec3) == sizeof(float) * 3, "transformPoints reads vec3 arrays as packed floats");
+
+mat4 multiply(const mat4& a, const mat4& b)
+{
+    float4 row0 = load4(a.rows), row1 = load4(a.rows + 4), row2 = load4(a.rows + 8), row3 = load4(a.rows + 12);
+
+    mat4 res;
+    for (int i = 0; i<16; i+=4)
+    {
+        float4 row = add4(add4(add4(mul4(splat4(b.rows[i]), row0), mul4(splat4(b.rows[i+1]), row1)), mul4(splat4(b.rows[i+2]), row2)), mul4(splat4(b.rows[i+3]), row3));
+        store4(res.rows + i, row);
+    }
+    return res;
+}
+
+//products of 2x2 matrices packed a b / c d into one float4: a * b, adj(a) * b and a * adj(b)
+static inline float4 mul2x2(float4 a, float4 b)
+{
+    return add4(mul4(a, shuffle4<0, 3, 0, 3>(b, b)), mul4(shuffle4<1, 0, 3, 2>(a, a), shuffle4<2, 1, 2, 1>(b, b)));
+}
+
+static inline float4 adjmul2x2(float4 a, float4 b)
+{
+    return sub4(mul4(shuffle4<3, 3, 0, 0>(a, a), b), mul4(shuffle4<1, 1, 2, 2>(a, a), shuffle4<2, 3, 0, 1>(b, b)));
+}
+
+static inline float4 muladj2x2(float4 a, float4 b)
+{
+    return sub4(mul4(a, shuffle4<3, 0, 3, 0>(b, b)), mul4(shuffle4<1, 0, 3, 2>(a, a), shuffle4<2, 1, 2, 1>(b, b)));
+}
+
+//splits the matrix into four 2x2 blocks A B / C D and builds the inverse from their adjugates and
+//determinants, which needs far fewer products than expanding all sixteen cofactors.
+bool inverse(const mat4& m, mat4& result)
+{
+    float4 row0 = load4(m.rows), row1 = load4(m.rows + 4), row2 = load4(m.rows + 8), row3 = load4(m.rows + 12);
+    float4 A = shuffle4<0, 1, 0, 1>(row0, row1), B = shuffle4<2, 3, 2, 3>(row0, row1);
+    float4 C = shuffle4<0, 1, 0, 1>(row2, row3), D = shuffle4<2, 3, 2, 3>(row2, row3);
+
+    //|A| |B| |C| |D|
+    float4 detSub = sub4(mul4(shuffle4<0, 2, 0, 2>(row0, row2), shuffle4<1, 3, 1, 3>(row1, row3)),
+                         mul4(shuffle4<1, 3, 1, 3>(row0, row2), shuffle4<0, 2, 0, 2>(row1, row3)));
+    float4 detA = shuffle4<0, 0, 0, 0>(detSub, detSub), detB = shuffle4<1, 1, 1, 1>(detSub, detSub);
+    float4 detC = shuffle4<2, 2, 2, 2>(detSub, detSub), detD = shuffle4<3, 3, 3, 3>(detSub, detSub);
+
+    float4 DC = adjmul2x2(D, C), AB = adjmul2x2(A, B);
+    float4 X = sub4(mul4(detD, A), mul2x2(B, DC));
+    float4 W = sub4(mul4(detA, D), mul2x2(C, AB));
+    float4 Y = sub4(mul4(detB, C), muladj2x2(D, AB));
+    float4 Z = sub4(mul4(detC, B), muladj2x2(A, DC));
+
+    //|M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+    float4 detM = add4(mul4(detA, detD), mul4(detB, detC));
+    detM = sub4(detM, hsum4(mul4(AB, shuffle4<0, 2, 1, 3>(DC, DC))));
+    float det = first4(detM);
+    if (det == 0.0f || !isfinite(det))
+        return false;
+
+    //the blocks still need their adjugate signs and order, which are folded into the final shuffles
+    float4 invDet = div4(set4(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X = mul4(X, invDet);
+    Y = mul4(Y, invDet);
+    Z = mul4(Z, invDet);
+    W = mul4(W, invDet);
+
+    store4(result.rows, shuffle4<3, 1, 3, 1>(X, Y));
+    store4(result.rows + 4, shuffle4<2, 0, 2, 0>(X, Y));
+    store4(result.rows + 8, shuffle4<3, 1, 3, 1>(Z, W));
+    store4(result.rows + 12, shuffle4<2, 0, 2, 0>(Z, W));
+    return true;
+}
+
+static inline float4 cross4(float4 a, float4 b)
+{
+    return sub4(mul4(yzx4(a), yzx4(yzx4(b))), mul4(yzx4(yzx4(a)), yzx4(b)));
+}
+
+//the inverse of the 3x3 part has the cross products of its rows as columns, and the translation
+//becomes minus that inverse applied to the old one.
+bool affineInverse(const mat4& m, mat4& result)
+{
+    float4 a = set4(m.rows[0], m.rows[1], m.rows[2], 0.0f);
+    float4 b = set4(m.rows[4], m.rows[5], m.rows[6], 0.0f);
+    float4 c = set4(m.rows[8], m.rows[9], m.rows[10], 0.0f);
+
+    float4 col0 = cross4(b, c), col1 = cross4(c, a), col2 = cross4(a, b);
+    float4 det = hsum4(mul4(a, col0));
+    float d = first4(det);
+    if (d == 0.0f || !isfinite(d))
+        return false;
+
+    float4 invDet = div4(splat4(1.0f), det);
+    col0 = mul4(col0, invDet);
+    col1 = mul4(col1, invDet);
+    col2 = mul4(col2, invDet);
+    float4 col3 = sub4(splat4(0.0f), add4(add4(mul4(col0, splat4(m.rows[3])), mul4(col1, splat4(m.rows[7]))), mul4(col2, splat4(m.rows[11]))));
+
+    //transpose the columns into rows, their w lanes are all zero
+    float4 t0 = shuffle4<0, 1, 0, 1>(col0, col1), t1 = shuffle4<2, 3, 2, 3>(col0, col1);
+    float4 t2 = shuffle4<0, 1, 0, 1>(col2, col3), t3 = shuffle4<2, 3, 2, 3>(col2, col3);
+    store4(result.rows, shuffle4<0, 2, 0, 2>(t0, t2));
+    store4(result.rows + 4, shuffle4<1, 3, 1, 3>(t0, t2));
+    store4(result.rows + 8, shuffle4<0, 2, 0, 2>(t1, t3));
+    result.rows[12] = 0.0f;
+    result.rows[13] = 0.0f;
+    result.rows[14] = 0.0f;
+    result.rows[15] = 1.0f;
+    return true;
+}
+
+//Four packed vec3s are three float4s, x0 y0 z0 x1 / y1 z1 x2 y2 / z2 x3 y3 z3. Rather than
+//shuffling them apart and back together, each output float4 is worked out in place: the matrix
+//rows are rotated to match the components in its lanes and the inputs spread to line up with them.
+template<bool translate>
+static void transform(const mat4& m, const vec3* in, vec3* out, size_t count)
+{
+    //rows[c] of the matrix row for the component in each lane of the first, second and third output
+    const float* r = m.rows;
+    float4 first[4], second[4], third[4];
+    for (int c = 0; c<4; c++)
+    {
+        first[c] = set4(r[c], r[4+c], r[8+c], r[c]);
+        second[c] = set4(r[4+c], r[8+c], r[c], r[4+c]);
+        third[c] = set4(r[8+c], r[c], r[4+c], r[8+c]);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= count; i+=4)
+    {
+        const float* p = &in[i].x;
+        float4 a = load4(p), b = load4(p + 4), c = load4(p + 8);
+
+        //x0 x0 x0 x1, y0 y0 y0 y1, z0 z0 z0 z1
+        float4 y01 = shuffle4<1, 1, 0, 0>(a, b), z01 = shuffle4<2, 2, 1, 1>(a, b);
+        float4 o0 = add4(add4(mul4(first[0], shuffle4<0, 0, 0, 3>(a, a)), mul4(first[1], shuffle4<0, 1, 1, 2>(y01, y01))), mul4(first[2], shuffle4<0, 1, 1, 2>(z01, z01)));
+
+        //x1 x1 x2 x2, y1 y1 y2 y2, z1 z1 z2 z2
+        float4 o1 = add4(add4(mul4(second[0], shuffle4<3, 3, 2, 2>(a, b)), mul4(second[1], shuffle4<0, 0, 3, 3>(b, b))), mul4(second[2], shuffle4<1, 1, 0, 0>(b, c)));
+
+        //x2 x3 x3 x3, y2 y3 y3 y3, z2 z3 z3 z3
+        float4 x23 = shuffle4<2, 2, 1, 1>(b, c), y23 = shuffle4<3, 3, 2, 2>(b, c);
+        float4 o2 = add4(add4(mul4(third[0], shuffle4<0, 2, 2, 2>(x23, x23)), mul4(third[1], shuffle4<0, 2, 2, 2>(y23, y23))), mul4(third[2], shuffle4<0, 3, 3, 3>(c, c)));
+
+        if (translate)
+        {
+            o0 = add4(o0, first[3]);
+            o1 = add4(o1, second[3]);
+            o2 = add4(o2, third[3]);
+        }
+
+        float* q = &out[i].x;
+        store4(q, o0);
+        store4(q + 4, o1);
+        store4(q + 8, o2);
+    }
+
+    for (; i<count; i++)
+        out[i] = translate ? transformPoint(m, in[i]) : transformDirection(m, in[i]);
+}
+
+void transformPoints(const mat4& m, const vec3* points, vec3* out, size_t count)
+{
+    transform<true>(m, points, out, count);
+}
+
+void transformDirections(const mat4& m, const vec3* directions, vec3* out, size_t count)
+{
+    transform<false>(m, directions, out, count);
+}
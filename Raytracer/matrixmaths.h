@@ -0,0 +1,49 @@
+//
+//  matrixmaths.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__matrixmaths__
+#define __Raytracer__matrixmaths__
+
+#include "simdmaths.h"
+#include <stddef.h>
+
+//mat4 operations built on float4 rows. Matrices are the row major mat4 from maths.h, transforming
+//column vectors, so translate puts the offset in the last column and a * b applies a then b.
+
+//same result as a * b, a row at a time.
+mat4 multiply(const mat4& a, const mat4& b);
+
+//inverse of any matrix, false if it's singular.
+bool inverse(const mat4& m, mat4& result);
+
+//inverse of a matrix whose bottom row is 0 0 0 1, which is anything built from rotations, scales
+//and translations. Cheaper than inverse, false if it's singular.
+bool affineInverse(const mat4& m, mat4& result);
+
+//transforms a point including the translation, ignoring the bottom row.
+inline vec3 transformPoint(const mat4& m, const vec3& p)
+{
+    return vec3(m.rows[0]*p.x + m.rows[1]*p.y + m.rows[2]*p.z + m.rows[3],
+                m.rows[4]*p.x + m.rows[5]*p.y + m.rows[6]*p.z + m.rows[7],
+                m.rows[8]*p.x + m.rows[9]*p.y + m.rows[10]*p.z + m.rows[11]);
+}
+
+//transforms a direction, leaving out the translation.
+inline vec3 transformDirection(const mat4& m, const vec3& d)
+{
+    return vec3(m.rows[0]*d.x + m.rows[1]*d.y + m.rows[2]*d.z,
+                m.rows[4]*d.x + m.rows[5]*d.y + m.rows[6]*d.z,
+                m.rows[8]*d.x + m.rows[9]*d.y + m.rows[10]*d.z);
+}
+
+//transformPoint and transformDirection over arrays, four vectors at a time with the same results.
+//out can be the same array as in.
+void transformPoints(const mat4& m, const vec3* points, vec3* out, size_t count);
+void transformDirections(const mat4& m, const vec3* directions, vec3* out, size_t count);
+
+#endif /* defined(__Raytracer__matrixmaths__) */
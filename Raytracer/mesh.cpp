@@ -0,0 +1,496 @@
+//
+//  mesh.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "mesh.h"
+#include "kernels.h"
+#include "threadpool.h"
+#include <limits.h>
+#include <stddef.h>
+#include <algorithm>
+#include <unordered_map>
+
+static AABB trianglebounds(const vec3& a, const vec3& b, const vec3& c)
+{
+    AABB bounds;
+    bounds.Grow(a);
+    bounds.Grow(b);
+    bounds.Grow(c);
+    return bounds;
+}
+
+template<typename Index>
+template<typename InputIndex>
+IndexedMesh<Index>::IndexedMesh(const std::vector<vec3>& vertices, const std::vector<InputIndex>& indices, const std::vector<InputIndex>& quadIndices) : vertices(vertices)
+{
+    //the faces are the triangles, then the halves of quads the quad test can't handle, then the
+    //quads. A quad's first and last corners always differ, so a repeated one marks a triangle.
+    std::vector<InputIndex> splitIndices, keptQuads;
+    for (size_t i = 0; i<quadIndices.size(); i+=4)
+    {
+        const InputIndex* q = &quadIndices[i];
+        if (Quad::CanRepresent(vertices[q[0]], vertices[q[1]], vertices[q[2]], vertices[q[3]]))
+            keptQuads.insert(keptQuads.end(), q, q + 4);
+        else
+        {
+            InputIndex halves[6] = { q[0], q[1], q[2], q[0], q[2], q[3] };
+            splitIndices.insert(splitIndices.end(), halves, halves + 6);
+        }
+    }
+    size_t triangleCount = indices.size() / 3, splitCount = splitIndices.size() / 3;
+    size_t faceCount = triangleCount + splitCount + keptQuads.size() / 4;
+    stride = keptQuads.empty() ? 3 : 4;
+    
+    //face f's corners into corners, the first repeated for triangles. Face numbers are widened before
+    //they're multiplied, three times a 32 bit one can overflow 32 bits.
+    auto facecorners = [&](size_t f, InputIndex* corners) {
+        const InputIndex* triangle = f < triangleCount ? &indices[f * 3] : f < triangleCount + splitCount ? &splitIndices[(f - triangleCount) * 3] : nullptr;
+        if (triangle)
+        {
+            corners[0] = triangle[0];
+            corners[1] = triangle[1];
+            corners[2] = triangle[2];
+            corners[3] = triangle[0];
+        }
+        else
+        {
+            const InputIndex* quad = &keptQuads[(f - triangleCount - splitCount) * 4];
+            for (int k = 0; k<4; k++)
+                corners[k] = quad[k];
+        }
+    };
+    
+    {
+        std::vector<AABB> bounds(faceCount);
+        parallelfor(0, faceCount, 1 << 14, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f<end; f++)
+            {
+                InputIndex corners[4];
+                facecorners(f, corners);
+                bounds[f] = trianglebounds(vertices[corners[0]], vertices[corners[1]], vertices[corners[2]]);
+                bounds[f].Grow(vertices[corners[3]]);
+            }
+        });
+        bvh.Build(bounds, 4);
+    }
+
+    //store the faces in leaf order so leaves index them directly
+    this->indices.reserve(faceCount * stride);
+    for (Index item : bvh.items)
+    {
+        InputIndex corners[4];
+        facecorners(item, corners);
+        for (int k = 0; k<stride; k++)
+            this->indices.push_back(corners[k]);
+    }
+    std::vector<Index>().swap(bvh.items);
+}
+
+template<typename Index>
+size_t IndexedMesh<Index>::MemoryUsage() const
+{
+    return vertices.size() * sizeof(vec3) + indices.size() * sizeof(Index) + bvh.MemoryUsage();
+}
+
+template<typename Index>
+bool IndexedMesh<Index>::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    float tMax = FLT_MAX;
+    bool hit = bvh.Traverse(ray, tMax, [&](Index first, Index count, float& t)
+    {
+        bool found = false;
+        for (Index i = first; i<first + count; i++)
+        {
+            const Index* face = &indices[(size_t)i * stride];
+            const vec3& v1 = vertices[face[0]];
+            float hitT;
+            bool faceHit = IsQuad(face) ? RaycastQuad(ray, v1, vertices[face[2]], vertices[face[1]] - v1, vertices[face[3]] - v1, hitT) : RaycastTriangle(ray, v1, vertices[face[1]] - v1, vertices[face[2]] - v1, hitT);
+            if (faceHit && hitT < t)
+            {
+                t = hitT;
+                element = i;
+                found = true;
+            }
+        }
+        return found;
+    });
+
+    intersection = tMax;
+    return hit;
+}
+
+static int tracepacket(const float* rays, const PacketMesh<uint32_t>& mesh, float* tMax, uint64_t* elements)
+{
+    return packetkernels().mesh(rays, mesh, tMax, elements);
+}
+
+static int tracepacket(const float* rays, const PacketMesh<uint64_t>& mesh, float* tMax, uint64_t* elements)
+{
+    return packetkernels().largeMesh(rays, mesh, tMax, elements);
+}
+
+template<typename Index>
+maskx8 IndexedMesh<Index>::RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements)
+{
+    typedef typename BasicBVH<Index>::Node Node;
+    typedef typename PacketMesh<Index>::Node PacketNode;
+    static_assert(sizeof(Node) == sizeof(PacketNode) && offsetof(Node, first) == offsetof(PacketNode, first), "the packet kernels read the hierarchy's nodes as PacketMesh::Node");
+    if (bvh.nodes.empty())
+        return lanemask8(0);
+
+    //the whole traversal is one call into the kernels built for this machine
+    PacketMesh<Index> mesh = { reinterpret_cast<const PacketNode*>(bvh.nodes.data()), vertices.data(), indices.data(), stride };
+    float tMax[8];
+    std::fill(tMax, tMax + 8, FLT_MAX);
+    int hits = tracepacket(rays.Floats(), mesh, tMax, elements);
+    intersection = floatx8::load(tMax);
+    return lanemask8(hits);
+}
+
+template<typename Index>
+vec3 IndexedMesh<Index>::GetNormal(const vec3& pos, uint64_t element)
+{
+    const Index* face = &indices[element * stride];
+    const vec3& v1 = vertices[face[0]];
+    return (vertices[face[1]] - v1).cross(vertices[IsQuad(face) ? face[3] : face[2]] - v1).normalize();
+}
+
+template struct IndexedMesh<uint32_t>;
+template struct IndexedMesh<uint64_t>;
+template IndexedMesh<uint32_t>::IndexedMesh(const std::vector<vec3>&, const std::vector<int>&, const std::vector<int>&);
+template IndexedMesh<uint64_t>::IndexedMesh(const std::vector<vec3>&, const std::vector<uint64_t>&, const std::vector<uint64_t>&);
+
+//builds a hierarchy over the triangles, giving the triangles in leaf order and the leaves as
+//ranges of that order.
+template<typename Tree>
+static void leafranges(const std::vector<AABB>& bounds, int maxLeafItems, std::vector<uint64_t>& order, std::vector<std::pair<uint64_t, uint64_t>>& leaves)
+{
+    Tree tree;
+    tree.Build(bounds, maxLeafItems);
+    for (const typename Tree::Node& node : tree.nodes)
+    {
+        if (node.count > 0)
+            leaves.push_back(std::make_pair(node.first, node.count));
+    }
+    std::sort(leaves.begin(), leaves.end());
+    order.assign(tree.items.begin(), tree.items.end());
+}
+
+template<typename InputIndex>
+ClusterMesh::ClusterMesh(const std::vector<vec3>& input, const std::vector<InputIndex>& inputIndices)
+{
+    size_t triangleCount = inputIndices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    //a fine hierarchy over the triangles orders them spatially, and its leaves become the groups.
+    //Triangles over a thousand times the median size are kept out of it, as sharing a cluster with
+    //them would leave their neighbours on a grid too coarse for their own size
+    std::vector<uint64_t> order, large;
+    std::vector<std::pair<uint64_t, uint64_t>> leaves;
+    {
+        std::vector<AABB> bounds;
+        std::vector<float> sizes;
+        bounds.reserve(triangleCount);
+        sizes.reserve(triangleCount);
+        for (size_t i = 0; i<triangleCount; i++)
+        {
+            bounds.push_back(trianglebounds(input[inputIndices[i*3]], input[inputIndices[i*3+1]], input[inputIndices[i*3+2]]));
+            sizes.push_back((bounds.back().max - bounds.back().min).maxComponent());
+        }
+
+        std::vector<float> sorted(sizes);
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        float largeSize = sorted[sorted.size() / 2] * 1024.0f;
+        std::vector<uint64_t> clustered;
+        size_t kept = 0;
+        for (size_t i = 0; i<triangleCount; i++)
+        {
+            if (largeSize > 0.0f && sizes[i] > largeSize)
+            {
+                large.push_back(i);
+                continue;
+            }
+            clustered.push_back(i);
+            bounds[kept++] = bounds[i];
+        }
+        bounds.resize(kept);
+
+        if (kept > BVH::MaxItems())
+            leafranges<LargeBVH>(bounds, groupTriangles, order, leaves);
+        else if (kept > 0)
+            leafranges<BVH>(bounds, groupTriangles, order, leaves);
+        for (uint64_t& triangle : order)
+            triangle = clustered[triangle];
+    }
+
+    //pack runs of neighbouring leaves into clusters while their triangles and vertices fit
+    std::vector<uint64_t> sources;//input vertex for each cluster vertex
+    std::unordered_map<uint64_t, uint8_t> local;
+    size_t leaf = 0;
+    while (leaf < leaves.size())
+    {
+        Cluster cluster = {};
+        cluster.firstVertex = sources.size();
+        cluster.firstIndex = indices.size();
+        local.clear();
+
+        int triangles = 0;
+        for (; leaf < leaves.size() && cluster.groupCount < maxGroups; leaf++)
+        {
+            uint64_t first = leaves[leaf].first, count = leaves[leaf].second;
+            if (triangles + (int)count > maxClusterTriangles)
+                break;
+
+            size_t added = 0;
+            uint64_t fresh[groupTriangles * 3];
+            for (uint64_t i = first; i<first + count; i++)
+            {
+                for (int k = 0; k<3; k++)
+                {
+                    uint64_t v = inputIndices[order[i]*3+k];
+                    if (!local.count(v) && std::find(fresh, fresh + added, v) == fresh + added)
+                        fresh[added++] = v;
+                }
+            }
+            if (local.size() + added > maxClusterVertices)
+                break;
+
+            for (uint64_t i = first; i<first + count; i++)
+            {
+                for (int k = 0; k<3; k++)
+                {
+                    uint64_t v = inputIndices[order[i]*3+k];
+                    auto found = local.find(v);
+                    if (found == local.end())
+                    {
+                        found = local.insert(std::make_pair(v, (uint8_t)local.size())).first;
+                        sources.push_back(v);
+                    }
+                    indices.push_back(found->second);
+                }
+            }
+
+            Group& group = cluster.groups[cluster.groupCount++];
+            group.first = (uint8_t)triangles;
+            group.count = (uint8_t)count;
+            triangles += count;
+        }
+        clusters.push_back(cluster);
+    }
+    std::vector<uint64_t>().swap(order);
+
+    //each cluster snaps its vertices to a power of two grid anchored at zero, on each axis the finest that
+    //spans the cluster in 16 bits and keeps every position exactly representable as a float, so decoding
+    //is exact. A vertex shared between clusters snaps to the coarsest of their grids, which lies on all of
+    //the finer ones too, so every cluster decodes it to the same position and the mesh stays watertight.
+    //That can widen a cluster enough to need a coarser grid itself, so repeat until nothing changes
+    const int unsnapped = INT_MIN;
+    std::vector<int> vertexExponents(input.size() * 3, unsnapped);
+    auto snap = [&](uint64_t v)
+    {
+        const vec3& p = input[v];
+        float axes[3] = { p.x, p.y, p.z };
+        for (int k = 0; k<3; k++)
+        {
+            int exponent = vertexExponents[v*3+k];
+            if (exponent != unsnapped)
+                axes[k] = ldexpf(roundf(ldexpf(axes[k], -exponent)), exponent);
+        }
+        return vec3(axes[0], axes[1], axes[2]);
+    };
+    std::vector<int> clusterExponents(clusters.size() * 3, unsnapped);
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t ci = 0; ci<clusters.size(); ci++)
+        {
+            uint64_t first = clusters[ci].firstVertex, end = ci + 1 < clusters.size() ? clusters[ci+1].firstVertex : sources.size();
+            AABB bounds;
+            for (uint64_t i = first; i<end; i++)
+                bounds.Grow(snap(sources[i]));
+
+            const float los[3] = { bounds.min.x, bounds.min.y, bounds.min.z }, his[3] = { bounds.max.x, bounds.max.y, bounds.max.z };
+            for (int k = 0; k<3; k++)
+            {
+                int& exponent = clusterExponents[ci*3+k];
+                if (exponent == unsnapped)
+                {
+                    //below 2^-24 of the largest magnitude some positions wouldn't fit in a float's 24 bits
+                    int magnitude;
+                    frexpf(std::max(fabsf(los[k]), fabsf(his[k])), &magnitude);
+                    exponent = std::max(magnitude - 24, -126);
+                }
+                while (his[k] - los[k] > ldexpf(65535.0f, exponent))
+                    exponent++;
+                for (uint64_t i = first; i<end; i++)
+                {
+                    int& vertex = vertexExponents[sources[i]*3+k];
+                    if (vertex < exponent)
+                    {
+                        vertex = exponent;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    vertices.resize(sources.size());
+    std::vector<AABB> clusterBounds;
+    clusterBounds.reserve(clusters.size());
+    for (size_t ci = 0; ci<clusters.size(); ci++)
+    {
+        Cluster& c = clusters[ci];
+        uint64_t end = ci + 1 < clusters.size() ? clusters[ci+1].firstVertex : sources.size();
+
+        //store offsets from the cluster's lowest grid position in steps of its grid
+        AABB grid;
+        for (uint64_t i = c.firstVertex; i<end; i++)
+            grid.Grow(snap(sources[i]));
+        c.base = grid.min;
+        c.step = vec3(ldexpf(1.0f, clusterExponents[ci*3]), ldexpf(1.0f, clusterExponents[ci*3+1]), ldexpf(1.0f, clusterExponents[ci*3+2]));
+        vec3 toGrid(1.0f / c.step.x, 1.0f / c.step.y, 1.0f / c.step.z);
+        for (uint64_t i = c.firstVertex; i<end; i++)
+        {
+            vec3 g = (snap(sources[i]) - c.base) * toGrid;
+            vertices[i] = { (uint16_t)g.x, (uint16_t)g.y, (uint16_t)g.z };
+        }
+
+        //bounds of the decoded vertices, padded by a grid step so flat clusters still have volume
+        AABB bounds;
+        for (uint64_t i = c.firstVertex; i<end; i++)
+            bounds.Grow(Decode(c, (uint8_t)(i - c.firstVertex)));
+        c.min = bounds.min - c.step;
+        c.extent = bounds.max + c.step - c.min;
+        clusterBounds.push_back(AABB(c.min, c.min + c.extent));
+
+        //round the group boxes outwards to 1/255ths of the cluster
+        vec3 scale(255.0f / c.extent.x, 255.0f / c.extent.y, 255.0f / c.extent.z);
+        for (int gi = 0; gi<c.groupCount; gi++)
+        {
+            Group& g = c.groups[gi];
+            AABB box;
+            for (int t = g.first; t<g.first + g.count; t++)
+            {
+                const uint8_t* tri = &indices[c.firstIndex + t*3];
+                box.Grow(trianglebounds(Decode(c, tri[0]), Decode(c, tri[1]), Decode(c, tri[2])));
+            }
+            vec3 qlo = (box.min - c.min) * scale, qhi = (box.max - c.min) * scale;
+            const float los[3] = { qlo.x, qlo.y, qlo.z }, his[3] = { qhi.x, qhi.y, qhi.z };
+            for (int k = 0; k<3; k++)
+            {
+                g.min[k] = (uint8_t)std::min(std::max(floorf(los[k]), 0.0f), 255.0f);
+                g.max[k] = (uint8_t)std::min(std::max(ceilf(his[k]), 0.0f), 255.0f);
+            }
+        }
+    }
+
+    //large triangles sit in the top level hierarchy on their own, with any corners they share with the
+    //clusters snapped the same way
+    for (uint64_t triangle : large)
+    {
+        Cluster c = {};
+        c.firstIndex = largeTriangles.size();
+        LargeTriangle t = { { snap(inputIndices[triangle*3]), snap(inputIndices[triangle*3+1]), snap(inputIndices[triangle*3+2]) } };
+        largeTriangles.push_back(t);
+        clusters.push_back(c);
+        clusterBounds.push_back(trianglebounds(t.corners[0], t.corners[1], t.corners[2]));
+    }
+
+    //the top level hierarchy has a cluster per leaf, store the clusters in leaf order
+    bvh.Build(clusterBounds, 1);
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size());
+    for (uint32_t item : bvh.items)
+        sorted.push_back(clusters[item]);
+    clusters.swap(sorted);
+    std::vector<uint32_t>().swap(bvh.items);
+}
+
+template ClusterMesh::ClusterMesh(const std::vector<vec3>&, const std::vector<int>&);
+template ClusterMesh::ClusterMesh(const std::vector<vec3>&, const std::vector<uint64_t>&);
+
+size_t ClusterMesh::MemoryUsage() const
+{
+    return clusters.size() * sizeof(Cluster) + vertices.size() * sizeof(QuantizedVertex) + indices.size() +
+        largeTriangles.size() * sizeof(LargeTriangle) + bvh.MemoryUsage();
+}
+
+bool ClusterMesh::RaycastCluster(const Ray& ray, uint32_t clusterIndex, float& tMax, uint64_t& element) const
+{
+    const Cluster& c = clusters[clusterIndex];
+    if (c.groupCount == 0)
+    {
+        const vec3* corners = largeTriangles[c.firstIndex].corners;
+        float hitT;
+        if (!RaycastTriangle(ray, corners[0], corners[1] - corners[0], corners[2] - corners[0], hitT) || hitT >= tMax)
+            return false;
+        tMax = hitT;
+        element = (uint64_t)clusterIndex << 8;
+        return true;
+    }
+
+    vec3 step = c.extent * (1.0f / 255.0f);
+
+    bool hit = false;
+    for (int gi = 0; gi<c.groupCount; gi++)
+    {
+        const Group& g = c.groups[gi];
+        AABB box(c.min + vec3(g.min[0], g.min[1], g.min[2]) * step, c.min + vec3(g.max[0], g.max[1], g.max[2]) * step);
+        float tEnter;
+        if (!box.Raycast(ray, tMax, tEnter))
+            continue;
+
+        for (int t = g.first; t<g.first + g.count; t++)
+        {
+            const uint8_t* tri = &indices[c.firstIndex + t*3];
+            vec3 v1 = Decode(c, tri[0]);
+            float hitT;
+            if (RaycastTriangle(ray, v1, Decode(c, tri[1]) - v1, Decode(c, tri[2]) - v1, hitT) && hitT < tMax)
+            {
+                tMax = hitT;
+                element = (uint64_t)clusterIndex << 8 | t;
+                hit = true;
+            }
+        }
+    }
+    return hit;
+}
+
+bool ClusterMesh::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    float tMax = FLT_MAX;
+    bool hit = bvh.Traverse(ray, tMax, [&](uint32_t first, uint32_t count, float& t)
+    {
+        bool found = false;
+        for (uint32_t i = first; i<first + count; i++)
+        {
+            if (RaycastCluster(ray, i, t, element))
+                found = true;
+        }
+        return found;
+    });
+
+    intersection = tMax;
+    return hit;
+}
+
+vec3 ClusterMesh::GetNormal(const vec3& pos, uint64_t element)
+{
+    const Cluster& c = clusters[element >> 8];
+    if (c.groupCount == 0)
+    {
+        const vec3* corners = largeTriangles[c.firstIndex].corners;
+        return (corners[1] - corners[0]).cross(corners[2] - corners[0]).normalize();
+    }
+
+    const uint8_t* tri = &indices[c.firstIndex + (element & 0xff) * 3];
+    vec3 v1 = Decode(c, tri[0]);
+    return (Decode(c, tri[1]) - v1).cross(Decode(c, tri[2]) - v1).normalize();
+}
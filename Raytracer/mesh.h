@@ -0,0 +1,147 @@
+//
+//  mesh.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__mesh__
+#define __Raytracer__mesh__
+
+#include "bvh.h"
+
+//an indexed triangle mesh with float vertices under a BVH, sharing one material. Use Mesh for the
+//compact 32 bit indices, which hold up to four billion vertices and BVH::MaxItems (about two billion)
+//triangles, and LargeMesh for anything bigger.
+template<typename Index>
+struct IndexedMesh : Primitive
+{
+    //indices has three per triangle and quadIndices four per quad, counter clockwise. Quads that
+    //Quad::CanRepresent are kept whole and intersected with RaycastQuad, the rest are split in two.
+    template<typename InputIndex>
+    IndexedMesh(const std::vector<vec3>& vertices, const std::vector<InputIndex>& indices, const std::vector<InputIndex>& quadIndices = std::vector<InputIndex>());
+
+    virtual Primitive* Clone() const
+    {
+        return new IndexedMesh(*this);
+    }
+
+    //the element returned is the index of the face hit in leaf order
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    //traces the packet through the hierarchy together, testing each leaf's faces against all its lanes,
+    //in one call to the packet kernels. Quads are tested as their two triangles.
+    virtual maskx8 RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        if (bvh.nodes.empty())
+            return false;
+        bounds = bvh.nodes[0].bounds;
+        return true;
+    }
+
+    //bytes used by the vertices, indices and hierarchy.
+    size_t MemoryUsage() const;
+
+private:
+    std::vector<vec3> vertices;
+    std::vector<Index> indices;//stride per face, in leaf order
+    //3 for a mesh of triangles. With quads every face has 4, triangles repeating their first corner.
+    int stride;
+    BasicBVH<Index> bvh;
+
+    bool IsQuad(const Index* face) const
+    {
+        return stride == 4 && face[3] != face[0];
+    }
+};
+
+typedef IndexedMesh<uint32_t> Mesh;
+typedef IndexedMesh<uint64_t> LargeMesh;
+
+//an indexed triangle mesh compressed into clusters of up to 64 triangles. Each cluster stores
+//its vertices as 16 bit offsets on its own power of two grid (a shared vertex snaps to the
+//coarsest grid of its clusters and decodes exactly, so neighbouring clusters agree on it and
+//the mesh stays watertight) and its triangles as byte indices into them. Clusters are split
+//into groups of up to eight triangles with byte quantized boxes, and vertices are decoded on
+//the fly only for the groups a ray passes through. Triangles far bigger than the rest are kept
+//out of the clusters so they don't coarsen their neighbours' grids.
+//It takes either 32 or 64 bit input indices.
+struct ClusterMesh : Primitive
+{
+    template<typename InputIndex>
+    ClusterMesh(const std::vector<vec3>& vertices, const std::vector<InputIndex>& indices);
+
+    virtual Primitive* Clone() const
+    {
+        return new ClusterMesh(*this);
+    }
+
+    //the element returned holds the cluster index above the triangle's index within the cluster
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        if (bvh.nodes.empty())
+            return false;
+        bounds = bvh.nodes[0].bounds;
+        return true;
+    }
+
+    //bytes used by the clusters and hierarchy.
+    size_t MemoryUsage() const;
+
+    size_t ClusterCount() const
+    {
+        return clusters.size();
+    }
+
+private:
+    static const int maxClusterTriangles = 64, maxClusterVertices = 256, groupTriangles = 8, maxGroups = maxClusterTriangles / groupTriangles;
+
+    struct Group
+    {
+        uint8_t min[3], max[3];//box in 1/255ths of the cluster bounds
+        uint8_t first, count;//triangles within the cluster
+    };
+
+    struct Cluster
+    {
+        vec3 min, extent;//bounds of the decoded vertices
+        vec3 base;//lowest grid position, the vertex offsets are relative to it
+        vec3 step;//grid spacing on each axis, a power of two
+        uint64_t firstVertex, firstIndex;//with no groups firstIndex is a large triangle instead
+        uint8_t groupCount;
+        Group groups[maxGroups];
+    };
+
+    struct QuantizedVertex
+    {
+        uint16_t x, y, z;
+    };
+
+    struct LargeTriangle
+    {
+        vec3 corners[3];
+    };
+
+    std::vector<Cluster> clusters;
+    std::vector<QuantizedVertex> vertices;
+    std::vector<uint8_t> indices;//three per triangle, relative to the cluster's first vertex
+    std::vector<LargeTriangle> largeTriangles;
+    BVH bvh;
+
+    vec3 Decode(const Cluster& cluster, uint8_t index) const
+    {
+        const QuantizedVertex& q = vertices[cluster.firstVertex + index];
+        return cluster.base + vec3((float)q.x, (float)q.y, (float)q.z) * cluster.step;
+    }
+
+    bool RaycastCluster(const Ray& ray, uint32_t clusterIndex, float& tMax, uint64_t& element) const;
+};
+
+#endif /* defined(__Raytracer__mesh__) */
@@ -0,0 +1,173 @@
+//
+//  numatopology.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "numatopology.h"
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+
+#if HAVE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+#endif
+
+//adds the cpus in a Linux cpu list like "0-3,8-11" to cpus
+static void parsecpulist(const char* list, std::vector<int>& cpus)
+{
+    int first, last, length;
+    while (sscanf(list, "%d%n", &first, &length) == 1)
+    {
+        list += length;
+        last = first;
+        if (*list == '-' && sscanf(list + 1, "%d%n", &last, &length) == 1)
+            list += 1 + length;
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+        if (*list != ',')
+            break;
+        list++;
+    }
+}
+
+#if defined(__linux__)
+//reads a one line file from /sys, false if it isn't there
+static bool readline(const char* path, char* line, int size)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+    bool read = fgets(line, size, file) != nullptr;
+    fclose(file);
+    return read;
+}
+#endif
+
+NumaTopology::NumaTopology()
+{
+#if HAVE_LIBNUMA
+    if (numa_available() >= 0)
+    {
+        struct bitmask* mask = numa_allocate_cpumask();
+        for (int id = 0; id <= numa_max_node(); id++)
+        {
+            Node node = { id, std::vector<int>() };
+            if (numa_node_to_cpus(id, mask) == 0)
+            {
+                for (int cpu = 0; cpu<(int)mask->size; cpu++)
+                {
+                    if (numa_bitmask_isbitset(mask, cpu))
+                        node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty())
+                nodes.push_back(node);
+        }
+        numa_free_cpumask(mask);
+    }
+#endif
+
+#if defined(__linux__)
+    char line[4096];
+    std::vector<int> online;
+    if (nodes.empty() && readline("/sys/devices/system/node/online", line, sizeof(line)))
+        parsecpulist(line, online);
+    for (int id : online)
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        Node node = { id, std::vector<int>() };
+        if (readline(path, line, sizeof(line)))
+            parsecpulist(line, node.cpus);
+        if (!node.cpus.empty())
+            nodes.push_back(node);
+    }
+#endif
+
+    if (nodes.empty())
+    {
+        Node node = { 0, std::vector<int>() };
+        for (int cpu = 0; cpu<(int)std::max(1u, std::thread::hardware_concurrency()); cpu++)
+            node.cpus.push_back(cpu);
+        nodes.push_back(node);
+    }
+}
+
+const NumaTopology& numatopology()
+{
+    static NumaTopology topology;
+    return topology;
+}
+
+#if defined(__linux__)
+//the cpus the thread was allowed before pinthread first pinned it, which unpinthread puts back. They
+//might be fewer than the topology has, under taskset or a cgroup.
+static thread_local cpu_set_t unpinnedCpus;
+static thread_local bool pinned = false;
+#endif
+
+bool pinthread(int cpu)
+{
+#if defined(__linux__)
+    if (!pinned && pthread_getaffinity_np(pthread_self(), sizeof(unpinnedCpus), &unpinnedCpus) != 0)
+        return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return false;
+    pinned = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void unpinthread()
+{
+#if defined(__linux__)
+    if (!pinned)
+        return;
+    pthread_setaffinity_np(pthread_self(), sizeof(unpinnedCpus), &unpinnedCpus);
+    pinned = false;
+#endif
+}
+
+void movetonode(const void* data, size_t size, int node)
+{
+#if defined(__linux__)
+    const NumaTopology& topology = numatopology();
+    if (topology.NodeCount() < 2 || size == 0)
+        return;
+
+    uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)data & ~(pageSize - 1), end = (uintptr_t)data + size;
+    std::vector<void*> pages;
+    for (uintptr_t page = first; page<end; page += pageSize)
+        pages.push_back((void*)page);
+    std::vector<int> nodes(pages.size(), topology.nodes[node].id), status(pages.size());
+
+    //move_pages is a plain system call, libnuma only wraps it
+#if HAVE_LIBNUMA
+    numa_move_pages(0, pages.size(), pages.data(), nodes.data(), status.data(), MPOL_MF_MOVE);
+#else
+    syscall(SYS_move_pages, 0, pages.size(), pages.data(), nodes.data(), status.data(), MPOL_MF_MOVE);
+#endif
+#endif
+}
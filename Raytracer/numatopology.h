@@ -0,0 +1,61 @@
+//
+//  numatopology.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__numatopology__
+#define __Raytracer__numatopology__
+
+#include <stddef.h>
+#include <vector>
+
+//Where the cpus and memory of a multi socket machine are, for keeping threads next to their data.
+//Uses libnuma when built with HAVE_LIBNUMA defined to 1 (and linked with -lnuma) and it reports NUMA
+//is available, otherwise reads the nodes from /sys on Linux. Anywhere else the machine is one node
+//holding every cpu, threads can't be pinned and memory stays where it is.
+#ifndef HAVE_LIBNUMA
+#define HAVE_LIBNUMA 0
+#endif
+
+//the nodes with cpus, numbered from 0 in the system's order
+struct NumaTopology
+{
+    NumaTopology();
+
+    int NodeCount() const
+    {
+        return (int)nodes.size();
+    }
+
+    const std::vector<int>& Cpus(int node) const
+    {
+        return nodes[node].cpus;
+    }
+
+private:
+    struct Node
+    {
+        //the system's number for the node, which skips nodes that only have memory
+        int id;
+        std::vector<int> cpus;
+    };
+    std::vector<Node> nodes;
+
+    friend void movetonode(const void* data, size_t size, int node);
+};
+
+//the machine's topology, worked out the first time it's asked for
+const NumaTopology& numatopology();
+
+//restricts the calling thread to cpu, returning false where threads can't be pinned
+bool pinthread(int cpu);
+//lets the calling thread run on the cpus it was allowed before pinthread first pinned it
+void unpinthread();
+
+//moves the pages covering size bytes from data to node. Pages that can't be moved stay where they are.
+void movetonode(const void* data, size_t size, int node);
+
+#endif /* defined(__Raytracer__numatopology__) */
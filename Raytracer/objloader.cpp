@@ -7,99 +7,304 @@
 //
 
 #include "objloader.h"
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <assert.h>
+#include "threadpool.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-using namespace std;
+//an obj file mapped into memory, so the chunks can be parsed straight out of the page cache without
+//copying the file first. An empty file maps to an empty range.
+struct MappedFile
+{
+    const char* data;
+    size_t size;
+
+    MappedFile(const char* path) : data(nullptr), size(0), opened(false)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+        {
+            size = (size_t)info.st_size;
+            void* mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+            opened = size == 0 || mapped != MAP_FAILED;
+            data = opened ? (const char*)mapped : nullptr;
+            if (!opened)
+                size = 0;
+        }
+        close(fd);
+    }
+
+    ~MappedFile()
+    {
+        Unmap();
+    }
+
+    bool IsOpen() const
+    {
+        return opened;
+    }
+
+    void Unmap()
+    {
+        if (data)
+            munmap((void*)data, size);
+        data = nullptr;
+        size = 0;
+    }
+
+private:
+    bool opened;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+//copies the next word of the line [pos, end) into token, skipping the spaces before it, and moves pos
+//past it. Words longer than token are cut short. False once the line has no more words.
+static bool nextword(const char*& pos, const char* end, char* token, size_t tokenSize)
+{
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r'))
+        pos++;
+    if (pos == end)
+        return false;
+
+    size_t length = 0;
+    for (; pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r'; pos++)
+    {
+        if (length + 1 < tokenSize)
+            token[length++] = *pos;
+    }
+    token[length] = '\0';
+    return true;
+}
 
-void LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices)
+//the next count words of the line as floats, missing ones being 0
+static void readfloats(const char*& pos, const char* end, float* values, int count)
 {
-    string line;
-    ifstream file(objFile);
-    if (file.is_open())
+    char token[64];
+    for (int i = 0; i<count; i++)
+        values[i] = nextword(pos, end, token, sizeof(token)) ? (float)atof(token) : 0.0f;
+}
+
+//parses the lines of an obj file in [begin, end), stopping at the first face it can't load
+template<typename Index>
+static LoadResult parseobj(const char *objFile, const char* begin, const char* end, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<Index>& indices, std::vector<Index>& quadIndices)
+{
+    for (const char* line = begin; line < end;)
     {
-        while (getline(file, line, '\n'))
+        const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+        lineEnd = lineEnd ? lineEnd : end;
+        const char* pos = line;
+        line = lineEnd + 1;
+
+        char token[64];
+        if (!nextword(pos, lineEnd, token, sizeof(token)))
+            continue;
+
+        if (strcmp(token, "v") == 0 || strcmp(token, "vn") == 0)
         {
-            istringstream liness(line);
-            getline(liness, line, ' ');
-            
-            if (line == "v")
-            {
-                string x, y, z;
-                getline(liness, x, ' ');
-                getline(liness, y, ' ');
-                getline(liness, z, ' ');
-                vertices.push_back(vec3(
-                    (float)atof(x.c_str()),
-                    (float)atof(y.c_str()),
-                    (float)atof(z.c_str())
-                ));
-            }
-            else if (line == "vt")
-            {
-                string u, v;
-                getline(liness, u, ' ');
-                getline(liness, v, ' ');
-                
-                texcoords.push_back(vec2(
-                                         (float)atof(u.c_str()),
-                                         (float)atof(v.c_str())
-                                         ));
-            }
-            else if (line == "vn")
+            float v[3];
+            readfloats(pos, lineEnd, v, 3);
+            (token[1] == 'n' ? normals : vertices).push_back(vec3(v[0], v[1], v[2]));
+        }
+        else if (strcmp(token, "vt") == 0)
+        {
+            float uv[2];
+            readfloats(pos, lineEnd, uv, 2);
+            texcoords.push_back(vec2(uv[0], uv[1]));
+        }
+        else if (strcmp(token, "f") == 0)
+        {
+            //three corners for a triangle or four for a quad, each the position index before any /
+            long long inds[4];
+            int corners = 0;
+            while (corners < 4 && nextword(pos, lineEnd, token, sizeof(token)))
+                inds[corners++] = strtoll(token, NULL, 10);
+            if (corners < 3)
             {
-                string x, y, z;
-                getline(liness, x, ' ');
-                getline(liness, y, ' ');
-                getline(liness, z, ' ');
-                normals.push_back(vec3(
-                                       (float)atof(x.c_str()),
-                                       (float)atof(y.c_str()),
-                                       (float)atof(z.c_str())
-                                       ));
+                fprintf(stderr, "%s: face with %d corners, only triangles and quads are supported\n", objFile, corners);
+                return LoadFailed;
             }
-            else if (line == "f")
+            
+            for (int i = 0; i<corners; i++)
             {
-                int inds[4];
-                for (int i = 0; i<4; i++)
+                //obj counts vertices from 1, negative indices count back from the last vertex read,
+                //which chunks parsed on their own can't know
+                if (inds[i] < 1)
                 {
-                    string indBits;
-                    getline(liness, indBits, ' ');
-                    istringstream iss(indBits);
-                    string bit;
-                    
-                    //Read Position
-                    if (getline(iss, bit, '/'))
-                    {
-                        inds[i] = atoi(bit.c_str()) - 1;//indices are counted from 1 for some reason
-                    }
-                    //Failing to read at this point means
-                    //this is a tri, not a quad.
-                    else
-                    {
-                        assert(i == 3);//we should have failed to read the 4th position
-                        inds[i] = -1;
-                        
-                        continue;
-                    }
+                    fprintf(stderr, "%s: face index %lld isn't supported, indices have to count up from 1\n", objFile, inds[i]);
+                    return LoadFailed;
                 }
+                inds[i]--;
                 
-                indices.push_back(inds[0]);
-                indices.push_back(inds[1]);
-                indices.push_back(inds[2]);
-                
-                if (inds[3] != -1)
-                {
-                    indices.push_back(inds[0]);
-                    indices.push_back(inds[2]);
-                    indices.push_back(inds[3]);
-                }
+                //a model past the range of the index type can't be loaded with it
+                if ((unsigned long long)inds[i] > (unsigned long long)std::numeric_limits<Index>::max())
+                    return LoadNeedsLargeIndices;
             }
+            
+            std::vector<Index>& to = corners == 4 ? quadIndices : indices;
+            for (int i = 0; i<corners; i++)
+                to.push_back((Index)inds[i]);
+        }
+    }
+    return LoadSucceeded;
+}
+
+//one piece of an obj file and what parsing it gave
+template<typename Index>
+struct ObjChunk
+{
+    const char *begin, *end;
+    std::vector<vec3> vertices, normals;
+    std::vector<vec2> texcoords;
+    std::vector<Index> indices, quadIndices;
+    LoadResult result;
+    //the largest index its faces use
+    Index largest;
+};
+
+//moves one of the vectors of every chunk onto the end of to in file order, freeing each chunk's as it
+//goes so the parsed data is only held once over. A lone chunk's is taken without copying.
+template<typename T, typename Chunk>
+static void gather(std::vector<T>& to, std::vector<Chunk>& chunks, std::vector<T> Chunk::*part)
+{
+    if (to.empty() && chunks.size() == 1)
+    {
+        to.swap(chunks[0].*part);
+        return;
+    }
+
+    size_t total = to.size();
+    for (const Chunk& chunk : chunks)
+        total += (chunk.*part).size();
+    to.reserve(total);
+    for (Chunk& chunk : chunks)
+    {
+        std::vector<T>& from = chunk.*part;
+        to.insert(to.end(), from.begin(), from.end());
+        std::vector<T>().swap(from);
+    }
+}
+
+//the largest of indices, 0 if there are none
+template<typename Index>
+static Index largestindex(const std::vector<Index>& indices)
+{
+    Index largest = 0;
+    for (Index index : indices)
+        largest = std::max(largest, index);
+    return largest;
+}
+
+//Splits the file into chunks of whole lines and parses them side by side on the task pool, straight
+//out of the mapped file. The chunks are added on in file order, so the result is the same as parsing
+//it in one go. Faces index the vertices from the start of the file, so chunks don't need to know about
+//each other, but whether the indices are in range can only be checked once they've all been parsed.
+template<typename Index>
+static LoadResult loadobj(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<Index>& indices, std::vector<Index>& quadIndices)
+{
+    MappedFile file(objFile);
+    if (!file.IsOpen())
+    {
+        fprintf(stderr, "%s: couldn't open it\n", objFile);
+        return LoadFailed;
+    }
+    
+    const size_t chunkSize = 1 << 20;
+    const char* fileEnd = file.data + file.size;
+    std::vector<ObjChunk<Index>> chunks;
+    for (const char* start = file.data; start < fileEnd;)
+    {
+        const char* end = start + std::min(chunkSize, (size_t)(fileEnd - start));
+        const char* newline = end < fileEnd ? (const char*)memchr(end, '\n', fileEnd - end) : nullptr;
+        end = newline ? newline + 1 : fileEnd;
+        chunks.push_back(ObjChunk<Index>());
+        chunks.back().begin = start;
+        chunks.back().end = end;
+        start = end;
+    }
+    
+    parallelfor(0, chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i<end; i++)
+        {
+            ObjChunk<Index>& chunk = chunks[i];
+            chunk.result = parseobj(objFile, chunk.begin, chunk.end, chunk.vertices, chunk.texcoords, chunk.normals, chunk.indices, chunk.quadIndices);
+            chunk.largest = std::max(largestindex(chunk.indices), largestindex(chunk.quadIndices));
+        }
+    });
+    file.Unmap();
+    
+    //the first chunk in the file that failed decides the result
+    size_t vertexCount = 0;
+    for (const ObjChunk<Index>& chunk : chunks)
+    {
+        if (chunk.result != LoadSucceeded)
+            return chunk.result;
+        vertexCount += chunk.vertices.size();
+    }
+    for (const ObjChunk<Index>& chunk : chunks)
+    {
+        if ((!chunk.indices.empty() || !chunk.quadIndices.empty()) && (unsigned long long)chunk.largest >= vertexCount)
+        {
+            fprintf(stderr, "%s: face index %llu is past the %zu vertices\n", objFile, (unsigned long long)chunk.largest + 1, vertexCount);
+            return LoadFailed;
         }
     }
     
-    file.close();
+    gather(vertices, chunks, &ObjChunk<Index>::vertices);
+    gather(texcoords, chunks, &ObjChunk<Index>::texcoords);
+    gather(normals, chunks, &ObjChunk<Index>::normals);
+    gather(indices, chunks, &ObjChunk<Index>::indices);
+    gather(quadIndices, chunks, &ObjChunk<Index>::quadIndices);
+    return LoadSucceeded;
+}
+
+//loads the model and splits each quad into two triangles
+template<typename Index>
+static LoadResult loadtriangles(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<Index>& indices)
+{
+    std::vector<Index> quadIndices;
+    LoadResult result = loadobj(objFile, vertices, texcoords, normals, indices, quadIndices);
+    
+    indices.reserve(indices.size() + quadIndices.size() / 4 * 6);
+    for (size_t i = 0; i<quadIndices.size(); i+=4)
+    {
+        indices.push_back(quadIndices[i]);
+        indices.push_back(quadIndices[i+1]);
+        indices.push_back(quadIndices[i+2]);
+        
+        indices.push_back(quadIndices[i]);
+        indices.push_back(quadIndices[i+2]);
+        indices.push_back(quadIndices[i+3]);
+    }
+    return result;
+}
+
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices)
+{
+    return loadtriangles(objFile, vertices, texcoords, normals, indices);
+}
+
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices, std::vector<int>& quadIndices)
+{
+    return loadobj(objFile, vertices, texcoords, normals, indices, quadIndices);
+}
+
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<uint64_t>& indices)
+{
+    return loadtriangles(objFile, vertices, texcoords, normals, indices);
+}
+
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<uint64_t>& indices, std::vector<uint64_t>& quadIndices)
+{
+    return loadobj(objFile, vertices, texcoords, normals, indices, quadIndices);
 }
@@ -11,7 +11,26 @@
 
 #include "maths.h"
 #include <vector>
+#include <stdint.h>
 
-void LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices);
+//how loading a model went. Unless it succeeded nothing is added to the outputs.
+enum LoadResult
+{
+    LoadSucceeded,
+    //the file couldn't be opened or has a face that can't be loaded, which has been reported
+    LoadFailed,
+    //an index is too big for int, the model has to be loaded with 64 bit indices
+    LoadNeedsLargeIndices
+};
+
+//loads an obj file, splitting any quads into triangles.
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices);
+
+//loads an obj file, keeping triangles in indices and quads (four indices each) in quadIndices.
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<int>& indices, std::vector<int>& quadIndices);
+
+//64 bit index versions of the above, for models with more vertices than fit in an int.
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<uint64_t>& indices);
+LoadResult LoadModel(const char *objFile, std::vector<vec3>& vertices, std::vector<vec2>& texcoords, std::vector<vec3>& normals, std::vector<uint64_t>& indices, std::vector<uint64_t>& quadIndices);
 
 #endif /* defined(__Raytracer__objloader__) */
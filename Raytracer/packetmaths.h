@@ -0,0 +1,380 @@
+//
+//  packetmaths.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__packetmaths__
+#define __Raytracer__packetmaths__
+
+#include "simdmaths.h"
+
+//Wide types for working on four or eight values at once, one per lane. Comparisons give masks
+//which pick lanes with select and are tested with any, all and none. floatx4 uses SSE, floatx8
+//uses AVX and falls back to a pair of floatx4, and both fall back to plain arrays without SSE.
+
+struct maskx4
+{
+    float4 m;
+
+    explicit maskx4(float4 m) : m(m)
+    {
+    }
+
+    inline maskx4 operator &(const maskx4& other) const { return maskx4(and4(m, other.m)); }
+    inline maskx4 operator |(const maskx4& other) const { return maskx4(or4(m, other.m)); }
+    inline maskx4 operator ~() const { return maskx4(andnot4(m, ones4())); }
+
+    //one bit per lane, lane 0 in bit 0
+    inline int bits() const { return bits4(m); }
+    inline bool any() const { return bits() != 0; }
+    inline bool all() const { return bits() == 0xf; }
+    inline bool none() const { return bits() == 0; }
+};
+
+struct floatx4
+{
+    typedef maskx4 mask;
+    static const int lanes = 4;
+
+    float4 m;
+
+    floatx4() : m(splat4(0.0f))
+    {
+    }
+
+    floatx4(float f) : m(splat4(f))
+    {
+    }
+
+    explicit floatx4(float4 m) : m(m)
+    {
+    }
+
+    static floatx4 load(const float* p)
+    {
+#if defined(__SSE2__)
+        return floatx4(_mm_loadu_ps(p));
+#else
+        return floatx4(set4(p[0], p[1], p[2], p[3]));
+#endif
+    }
+
+    void store(float* p) const
+    {
+#if defined(__SSE2__)
+        _mm_storeu_ps(p, m);
+#else
+        memcpy(p, m.v, sizeof(m.v));
+#endif
+    }
+
+    inline float operator [](int lane) const
+    {
+        float v[4];
+        store(v);
+        return v[lane];
+    }
+
+    inline floatx4 operator +(const floatx4& other) const { return floatx4(add4(m, other.m)); }
+    inline floatx4 operator -(const floatx4& other) const { return floatx4(sub4(m, other.m)); }
+    inline floatx4 operator *(const floatx4& other) const { return floatx4(mul4(m, other.m)); }
+    inline floatx4 operator /(const floatx4& other) const { return floatx4(div4(m, other.m)); }
+    inline floatx4 operator -() const { return floatx4(sub4(splat4(0.0f), m)); }
+
+    inline maskx4 operator <(const floatx4& other) const { return maskx4(cmplt4(m, other.m)); }
+    inline maskx4 operator <=(const floatx4& other) const { return maskx4(cmple4(m, other.m)); }
+    inline maskx4 operator >(const floatx4& other) const { return maskx4(cmplt4(other.m, m)); }
+    inline maskx4 operator >=(const floatx4& other) const { return maskx4(cmple4(other.m, m)); }
+    inline maskx4 operator ==(const floatx4& other) const { return maskx4(cmpeq4(m, other.m)); }
+    inline maskx4 operator !=(const floatx4& other) const { return maskx4(cmpneq4(m, other.m)); }
+
+    inline floatx4 min(const floatx4& other) const { return floatx4(min4(m, other.m)); }
+    inline floatx4 max(const floatx4& other) const { return floatx4(max4(m, other.m)); }
+    inline floatx4 sqrt() const { return floatx4(sqrt4(m)); }
+
+    //a where the mask is set, otherwise b
+    static inline floatx4 select(const maskx4& mask, const floatx4& a, const floatx4& b) { return floatx4(select4(mask.m, a.m, b.m)); }
+};
+
+#if defined(__AVX__)
+
+struct maskx8
+{
+    __m256 m;
+
+    explicit maskx8(__m256 m) : m(m)
+    {
+    }
+
+    inline maskx8 operator &(const maskx8& other) const { return maskx8(_mm256_and_ps(m, other.m)); }
+    inline maskx8 operator |(const maskx8& other) const { return maskx8(_mm256_or_ps(m, other.m)); }
+    inline maskx8 operator ~() const { return maskx8(_mm256_xor_ps(m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))); }
+
+    inline int bits() const { return _mm256_movemask_ps(m); }
+    inline bool any() const { return !_mm256_testz_ps(m, m); }
+    inline bool all() const { return bits() == 0xff; }
+    inline bool none() const { return _mm256_testz_ps(m, m) != 0; }
+};
+
+struct floatx8
+{
+    typedef maskx8 mask;
+    static const int lanes = 8;
+
+    __m256 m;
+
+    floatx8() : m(_mm256_setzero_ps())
+    {
+    }
+
+    floatx8(float f) : m(_mm256_set1_ps(f))
+    {
+    }
+
+    explicit floatx8(__m256 m) : m(m)
+    {
+    }
+
+    static floatx8 load(const float* p) { return floatx8(_mm256_loadu_ps(p)); }
+    void store(float* p) const { _mm256_storeu_ps(p, m); }
+
+    inline float operator [](int lane) const
+    {
+        float v[8];
+        store(v);
+        return v[lane];
+    }
+
+    inline floatx8 operator +(const floatx8& other) const { return floatx8(_mm256_add_ps(m, other.m)); }
+    inline floatx8 operator -(const floatx8& other) const { return floatx8(_mm256_sub_ps(m, other.m)); }
+    inline floatx8 operator *(const floatx8& other) const { return floatx8(_mm256_mul_ps(m, other.m)); }
+    inline floatx8 operator /(const floatx8& other) const { return floatx8(_mm256_div_ps(m, other.m)); }
+    inline floatx8 operator -() const { return floatx8(_mm256_sub_ps(_mm256_setzero_ps(), m)); }
+
+    inline maskx8 operator <(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_LT_OQ)); }
+    inline maskx8 operator <=(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_LE_OQ)); }
+    inline maskx8 operator >(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_GT_OQ)); }
+    inline maskx8 operator >=(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_GE_OQ)); }
+    inline maskx8 operator ==(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_EQ_OQ)); }
+    inline maskx8 operator !=(const floatx8& other) const { return maskx8(_mm256_cmp_ps(m, other.m, _CMP_NEQ_UQ)); }
+
+    inline floatx8 min(const floatx8& other) const { return floatx8(_mm256_min_ps(m, other.m)); }
+    inline floatx8 max(const floatx8& other) const { return floatx8(_mm256_max_ps(m, other.m)); }
+    inline floatx8 sqrt() const { return floatx8(_mm256_sqrt_ps(m)); }
+
+    static inline floatx8 select(const maskx8& mask, const floatx8& a, const floatx8& b) { return floatx8(_mm256_blendv_ps(b.m, a.m, mask.m)); }
+};
+
+#else
+
+//without AVX eight lanes are two halves of four
+struct maskx8
+{
+    maskx4 lo, hi;
+
+    maskx8(maskx4 lo, maskx4 hi) : lo(lo), hi(hi)
+    {
+    }
+
+    inline maskx8 operator &(const maskx8& other) const { return maskx8(lo & other.lo, hi & other.hi); }
+    inline maskx8 operator |(const maskx8& other) const { return maskx8(lo | other.lo, hi | other.hi); }
+    inline maskx8 operator ~() const { return maskx8(~lo, ~hi); }
+
+    inline int bits() const { return lo.bits() | hi.bits() << 4; }
+    inline bool any() const { return bits() != 0; }
+    inline bool all() const { return bits() == 0xff; }
+    inline bool none() const { return bits() == 0; }
+};
+
+struct floatx8
+{
+    typedef maskx8 mask;
+    static const int lanes = 8;
+
+    floatx4 lo, hi;
+
+    floatx8()
+    {
+    }
+
+    floatx8(float f) : lo(f), hi(f)
+    {
+    }
+
+    floatx8(floatx4 lo, floatx4 hi) : lo(lo), hi(hi)
+    {
+    }
+
+    static floatx8 load(const float* p) { return floatx8(floatx4::load(p), floatx4::load(p + 4)); }
+
+    void store(float* p) const
+    {
+        lo.store(p);
+        hi.store(p + 4);
+    }
+
+    inline float operator [](int lane) const { return lane < 4 ? lo[lane] : hi[lane - 4]; }
+
+    inline floatx8 operator +(const floatx8& other) const { return floatx8(lo + other.lo, hi + other.hi); }
+    inline floatx8 operator -(const floatx8& other) const { return floatx8(lo - other.lo, hi - other.hi); }
+    inline floatx8 operator *(const floatx8& other) const { return floatx8(lo * other.lo, hi * other.hi); }
+    inline floatx8 operator /(const floatx8& other) const { return floatx8(lo / other.lo, hi / other.hi); }
+    inline floatx8 operator -() const { return floatx8(-lo, -hi); }
+
+    inline maskx8 operator <(const floatx8& other) const { return maskx8(lo < other.lo, hi < other.hi); }
+    inline maskx8 operator <=(const floatx8& other) const { return maskx8(lo <= other.lo, hi <= other.hi); }
+    inline maskx8 operator >(const floatx8& other) const { return maskx8(lo > other.lo, hi > other.hi); }
+    inline maskx8 operator >=(const floatx8& other) const { return maskx8(lo >= other.lo, hi >= other.hi); }
+    inline maskx8 operator ==(const floatx8& other) const { return maskx8(lo == other.lo, hi == other.hi); }
+    inline maskx8 operator !=(const floatx8& other) const { return maskx8(lo != other.lo, hi != other.hi); }
+
+    inline floatx8 min(const floatx8& other) const { return floatx8(lo.min(other.lo), hi.min(other.hi)); }
+    inline floatx8 max(const floatx8& other) const { return floatx8(lo.max(other.lo), hi.max(other.hi)); }
+    inline floatx8 sqrt() const { return floatx8(lo.sqrt(), hi.sqrt()); }
+
+    static inline floatx8 select(const maskx8& mask, const floatx8& a, const floatx8& b) { return floatx8(floatx4::select(mask.lo, a.lo, b.lo), floatx4::select(mask.hi, a.hi, b.hi)); }
+};
+
+#endif
+
+//masks with the lanes set in bits, lane 0 in bit 0
+inline maskx4 lanemask4(int bits)
+{
+#if defined(__SSE2__)
+    __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    return maskx4(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), laneBits), laneBits)));
+#else
+    return floatx4(set4((float)(bits & 1), (float)(bits >> 1 & 1), (float)(bits >> 2 & 1), (float)(bits >> 3 & 1))) != 0.0f;
+#endif
+}
+
+inline maskx8 lanemask8(int bits)
+{
+#if defined(__AVX2__)
+    __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return maskx8(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), laneBits), laneBits)));
+#elif defined(__AVX__)
+    return maskx8(_mm256_insertf128_ps(_mm256_castps128_ps256(lanemask4(bits).m), lanemask4(bits >> 4).m, 1));
+#else
+    return maskx8(lanemask4(bits), lanemask4(bits >> 4));
+#endif
+}
+
+//a 3D vector per lane, stored as structure of arrays with the same operators as vec3.
+template<typename F>
+struct vec3x
+{
+    typedef typename F::mask mask;
+
+    F x, y, z;
+
+    vec3x()
+    {
+    }
+
+    vec3x(F x, F y, F z) : x(x), y(y), z(z)
+    {
+    }
+
+    //the same vector in every lane
+    explicit vec3x(const vec3& v) : x(v.x), y(v.y), z(v.z)
+    {
+    }
+
+    //lane i of the vector
+    inline vec3 operator [](int lane) const
+    {
+        return vec3(x[lane], y[lane], z[lane]);
+    }
+
+    inline vec3x operator *(const F& scalar) const
+    {
+        return vec3x(x * scalar, y * scalar, z * scalar);
+    }
+
+    inline vec3x operator +(const vec3x& other) const
+    {
+        return vec3x(x + other.x, y + other.y, z + other.z);
+    }
+
+    inline vec3x operator *(const vec3x& other) const
+    {
+        return vec3x(x * other.x, y * other.y, z * other.z);
+    }
+
+    inline void operator +=(const vec3x& other)
+    {
+        x = x + other.x;
+        y = y + other.y;
+        z = z + other.z;
+    }
+
+    inline vec3x operator -(const vec3x& other) const
+    {
+        return vec3x(x - other.x, y - other.y, z - other.z);
+    }
+
+    inline F dot(const vec3x& other) const
+    {
+        return x*other.x + y*other.y + z*other.z;
+    }
+
+    inline F lengthSq() const
+    {
+        return dot(*this);
+    }
+
+    inline F length() const
+    {
+        return lengthSq().sqrt();
+    }
+
+    inline vec3x normalize() const
+    {
+        F invLength = F(1.0f) / length();
+        return *this * invLength;
+    }
+
+    inline vec3x cross(const vec3x& other) const
+    {
+        return vec3x(
+                     y*other.z - z*other.y,
+                     z*other.x - x*other.z,
+                     x*other.y - y*other.x
+                     );
+    }
+
+    inline vec3x min(const vec3x& other) const
+    {
+        return vec3x(x.min(other.x), y.min(other.y), z.min(other.z));
+    }
+
+    inline vec3x max(const vec3x& other) const
+    {
+        return vec3x(x.max(other.x), y.max(other.y), z.max(other.z));
+    }
+
+    inline F minComponent() const
+    {
+        return x.min(y).min(z);
+    }
+
+    inline F maxComponent() const
+    {
+        return x.max(y).max(z);
+    }
+
+    //a where the mask is set, otherwise b
+    static inline vec3x select(const mask& m, const vec3x& a, const vec3x& b)
+    {
+        return vec3x(F::select(m, a.x, b.x), F::select(m, a.y, b.y), F::select(m, a.z, b.z));
+    }
+};
+
+typedef vec3x<floatx4> vec3x4;
+typedef vec3x<floatx8> vec3x8;
+
+#endif /* defined(__Raytracer__packetmaths__) */
@@ -0,0 +1,96 @@
+//
+//  pixelorder.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "pixelorder.h"
+#include <algorithm>
+#include <string.h>
+
+static const char* orderNames[PixelOrderCount] = { "scanline", "morton", "hilbert" };
+
+bool findpixelorder(const char* name, PixelOrder& order)
+{
+    for (int i = 0; i<PixelOrderCount; i++)
+    {
+        if (strcmp(orderNames[i], name) == 0)
+        {
+            order = (PixelOrder)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* pixelordername(PixelOrder order)
+{
+    return orderNames[order];
+}
+
+//spreads the low 16 bits of v out to the even bits
+static uint32_t spreadbits(uint32_t v)
+{
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+uint32_t mortonindex(uint32_t x, uint32_t y)
+{
+    return spreadbits(x) | (spreadbits(y) << 1);
+}
+
+uint32_t hilbertindex(uint32_t x, uint32_t y, uint32_t size)
+{
+    uint32_t index = 0;
+    for (uint32_t half = size / 2; half > 0; half /= 2)
+    {
+        uint32_t right = (x & half) ? 1 : 0, top = (y & half) ? 1 : 0;
+        index += half * half * ((3 * right) ^ top);
+
+        //turn the quadrant so the curve through it starts and ends next to its neighbours'
+        if (top == 0)
+        {
+            if (right == 1)
+            {
+                x = size - 1 - x;
+                y = size - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+void curveorder(PixelOrder order, int width, int height, std::vector<uint32_t>& cells)
+{
+    cells.clear();
+    for (int y = 0; y<height; y++)
+        for (int x = 0; x<width; x++)
+            cells.push_back((uint32_t)y << 16 | (uint32_t)x);
+    if (order == OrderScanline)
+        return;
+
+    uint32_t size = 1;
+    while (size < (uint32_t)std::max(width, height))
+        size *= 2;
+
+    //sorting by the curve index with the cell below it keeps it to one pass over the grid
+    std::vector<uint64_t> keyed;
+    keyed.reserve(cells.size());
+    for (uint32_t cell : cells)
+    {
+        uint32_t x = cell & 0xffff, y = cell >> 16;
+        uint64_t index = order == OrderMorton ? mortonindex(x, y) : hilbertindex(x, y, size);
+        keyed.push_back(index << 32 | cell);
+    }
+    std::sort(keyed.begin(), keyed.end());
+    for (size_t i = 0; i<keyed.size(); i++)
+        cells[i] = (uint32_t)keyed[i];
+}
@@ -0,0 +1,43 @@
+//
+//  pixelorder.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__pixelorder__
+#define __Raytracer__pixelorder__
+
+#include <stdint.h>
+#include <vector>
+
+//The orders the renderer can walk a grid in, the packets of a tile or the tiles of the image. Scanline
+//goes row by row. The space filling curves keep cells that are close in 2D close in time as well, so
+//rays traced one after another tend to need the same hierarchy nodes and geometry. That this cuts L2
+//and L3 misses is expected but not measured, -benchmark order counts L1D and LLC misses where the
+//machine gives out the counters.
+enum PixelOrder
+{
+    OrderScanline,
+    //Z order, from interleaving the bits of x and y
+    OrderMorton,
+    //like Morton but without its long jumps, every step moves to a neighbouring cell
+    OrderHilbert,
+    PixelOrderCount
+};
+
+//looks an order up by name, false if there isn't one called that
+bool findpixelorder(const char* name, PixelOrder& order);
+const char* pixelordername(PixelOrder order);
+
+//x and y's bits interleaved, x in the lower bit of each pair
+uint32_t mortonindex(uint32_t x, uint32_t y);
+//how far along the Hilbert curve through a size by size grid (x, y) is, size being a power of two
+uint32_t hilbertindex(uint32_t x, uint32_t y, uint32_t size);
+
+//the cells of a width by height grid in order, each as y << 16 | x. Curves run through the smallest
+//power of two square holding the grid, skipping the cells outside it.
+void curveorder(PixelOrder order, int width, int height, std::vector<uint32_t>& cells);
+
+#endif /* defined(__Raytracer__pixelorder__) */
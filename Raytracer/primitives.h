@@ -0,0 +1,515 @@
+//
+//  primitives.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__primitives__
+#define __Raytracer__primitives__
+
+#include "maths.h"
+#include "packetmaths.h"
+#include <stdint.h>
+#include <float.h>
+
+struct Ray
+{
+    vec3 origin, direction, invDirection;
+
+    Ray()
+    {
+    }
+
+    Ray(vec3 origin, vec3 direction) : origin(origin), direction(direction), invDirection(1.0f/direction.x, 1.0f/direction.y, 1.0f/direction.z)
+    {
+    }
+};
+
+//eight rays traced together, one per lane.
+struct RayPacket
+{
+    vec3x8 origin, direction, invDirection;
+
+    RayPacket()
+    {
+    }
+
+    RayPacket(const vec3x8& origin, const vec3x8& direction) : origin(origin), direction(direction), invDirection(floatx8(1.0f) / direction.x, floatx8(1.0f) / direction.y, floatx8(1.0f) / direction.z)
+    {
+    }
+
+    //gathers eight rays into the lanes of a packet.
+    explicit RayPacket(const Ray* rays)
+    {
+        float lanes[6][8];
+        for (int i = 0; i<8; i++)
+        {
+            lanes[0][i] = rays[i].origin.x; lanes[1][i] = rays[i].origin.y; lanes[2][i] = rays[i].origin.z;
+            lanes[3][i] = rays[i].direction.x; lanes[4][i] = rays[i].direction.y; lanes[5][i] = rays[i].direction.z;
+        }
+        *this = RayPacket(vec3x8(floatx8::load(lanes[0]), floatx8::load(lanes[1]), floatx8::load(lanes[2])),
+                          vec3x8(floatx8::load(lanes[3]), floatx8::load(lanes[4]), floatx8::load(lanes[5])));
+    }
+
+    Ray Lane(int i) const
+    {
+        return Ray(origin[i], direction[i]);
+    }
+
+    //the lanes as nine arrays of eight floats, origin xyz, direction xyz then invDirection xyz, for the kernels.
+    const float* Floats() const
+    {
+        return reinterpret_cast<const float*>(this);
+    }
+};
+
+static_assert(sizeof(RayPacket) == sizeof(float) * 8 * 9, "RayPacket::Floats expects the lanes to be packed");
+
+//an axis aligned bounding box.
+struct AABB
+{
+    vec3 min, max;
+
+    AABB() : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+    {}
+
+    AABB(vec3 min, vec3 max) : min(min), max(max)
+    {}
+
+    void Grow(const vec3& p)
+    {
+        min = min.min(p);
+        max = max.max(p);
+    }
+
+    void Grow(const AABB& other)
+    {
+        min = min.min(other.min);
+        max = max.max(other.max);
+    }
+
+    vec3 Center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    float SurfaceArea() const
+    {
+        vec3 d = max - min;
+        return d.x < 0.0f ? 0.0f : 2.0f * (d.x*d.y + d.y*d.z + d.z*d.x);
+    }
+
+    //slab test returning the distance the ray enters the box, if it does so before tMax.
+    bool Raycast(const Ray& ray, float tMax, float& tEnter) const
+    {
+        vec3 t0 = (min - ray.origin) * ray.invDirection;
+        vec3 t1 = (max - ray.origin) * ray.invDirection;
+        float tNear = t0.min(t1).maxComponent(), tFar = t0.max(t1).minComponent();
+        tEnter = tNear > 0.0f ? tNear : 0.0f;
+        return tEnter <= (tFar < tMax ? tFar : tMax);
+    }
+
+    //Raycast for a packet of rays, giving the lanes whose ray enters the box before its tMax.
+    maskx8 RaycastPacket(const RayPacket& rays, const floatx8& tMax, floatx8& tEnter) const
+    {
+        vec3x8 t0 = (vec3x8(min) - rays.origin) * rays.invDirection;
+        vec3x8 t1 = (vec3x8(max) - rays.origin) * rays.invDirection;
+        floatx8 tNear = t0.min(t1).maxComponent(), tFar = t0.max(t1).minComponent();
+        tEnter = tNear.max(0.0f);
+        return tEnter <= tFar.min(tMax);
+    }
+};
+
+//the volume swept by rays from a shared origin through a convex outline, bounded by a plane through
+//the origin along each edge of the outline. Used to skip boxes none of the rays can reach.
+struct Frustum
+{
+    vec3 origin, normals[4];
+
+    //corners are the directions of the rays at the four corners of the outline, in order around it.
+    Frustum(const vec3& origin, const vec3* corners) : origin(origin)
+    {
+        vec3 center = corners[0] + corners[1] + corners[2] + corners[3];
+        for (int i = 0; i<4; i++)
+        {
+            normals[i] = corners[i].cross(corners[(i+1) % 4]);
+            if (normals[i].dot(center) < 0.0f)
+                normals[i] = normals[i] * -1.0f;
+        }
+    }
+
+    //conservative test, false only if the box lies entirely outside one of the planes.
+    bool Overlaps(const AABB& box) const
+    {
+        for (int i = 0; i<4; i++)
+        {
+            const vec3& n = normals[i];
+            vec3 furthest(n.x > 0.0f ? box.max.x : box.min.x, n.y > 0.0f ? box.max.y : box.min.y, n.z > 0.0f ? box.max.z : box.min.z);
+            if ((furthest - origin).dot(n) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+
+struct Material
+{
+    float reflect, diffuse, spec;
+    //specular exponent
+    unsigned int shininess;
+    vec3 color;
+
+    Material() : reflect(0.0f), diffuse(1.0f), spec(1.0f), shininess(20), color(vec3(1.0f,1.0f,1.0f))
+    { }
+};
+
+struct Primitive
+{
+    Material material;
+    const char* name;
+    bool isLight = false;
+
+    virtual ~Primitive() {}
+
+    //element identifies which part of the primitive was hit (a triangle of a mesh, a voxel face)
+    //and is handed back to GetNormal. Primitives made of a single surface can ignore it.
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element) = 0;
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element) = 0;
+    //a copy sharing nothing with this one, for keeping one per NUMA node
+    virtual Primitive* Clone() const = 0;
+
+    //Raycast for eight rays at once, returning the lanes hit. intersection and elements are only
+    //filled in for those lanes. Primitives without a packet kernel trace the lanes one by one.
+    virtual maskx8 RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements)
+    {
+        float t[8];
+        int hits = 0;
+        for (int i = 0; i<8; i++)
+        {
+            if (Raycast(rays.Lane(i), t[i], elements[i]))
+                hits |= 1 << i;
+        }
+        intersection = floatx8::load(t);
+        return lanemask8(hits);
+    }
+
+    //bounds of the primitive, or false if it's unbounded.
+    virtual bool GetBounds(AABB& bounds)
+    {
+        return false;
+    }
+};
+
+struct Sphere : Primitive
+{
+    vec3 pos;
+    float radius, radiusSq;
+
+    Sphere(vec3 pos, float radius) : pos(pos), radius(radius), radiusSq(radius*radius)
+    {}
+
+    virtual Primitive* Clone() const
+    {
+        return new Sphere(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element)
+    {
+        vec3 l = pos - ray.origin;//vector from sphere pos to ray origin
+        float distToCenter = l.dot(ray.direction);
+        if (distToCenter < 0.0f)//sphere behind ray
+            return false;
+        float distToIntersectSq = l.dot(l) - distToCenter * distToCenter;//pythagorous theorum to get intersection dist from sphere midpoint along ray
+        if (distToIntersectSq > radiusSq)
+            return false;
+
+        intersection = distToCenter - sqrtf(radiusSq - distToIntersectSq);
+        return true;
+    }
+
+    virtual maskx8 RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements)
+    {
+        vec3x8 l = vec3x8(pos) - rays.origin;
+        floatx8 distToCenter = l.dot(rays.direction);
+        floatx8 distToIntersectSq = l.dot(l) - distToCenter * distToCenter;
+        intersection = distToCenter - (floatx8(radiusSq) - distToIntersectSq).max(0.0f).sqrt();
+        return (distToCenter >= 0.0f) & (distToIntersectSq <= radiusSq);
+    }
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        bounds = AABB(pos - vec3(radius, radius, radius), pos + vec3(radius, radius, radius));
+        return true;
+    }
+
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element)
+    {
+        return (pos - this->pos).normalize();
+    }
+};
+
+struct Plane : Primitive
+{
+    vec3 normal;
+    float offset;
+
+    Plane(vec3 normal, float offset) : normal(normal), offset(offset)
+    {}
+
+    virtual Primitive* Clone() const
+    {
+        return new Plane(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element)
+    {
+        float ldotn = normal.dot(ray.direction);
+        if (ldotn == 0.0f)
+            return false;
+
+        intersection = (offset - normal.dot(ray.origin)) / ldotn;
+        return intersection > 0.0f;
+    }
+
+    virtual maskx8 RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements)
+    {
+        vec3x8 n(normal);
+        floatx8 ldotn = n.dot(rays.direction);
+        intersection = (floatx8(offset) - n.dot(rays.origin)) / ldotn;
+        return (ldotn != 0.0f) & (intersection > 0.0f);
+    }
+
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element)
+    {
+        return normal;
+    }
+};
+
+//an axis aligned box, intersected with a branchless slab test.
+struct Box : Primitive
+{
+    vec3 min, max, center, halfSize;
+
+    Box(vec3 min, vec3 max) : min(min), max(max), center((min + max) * 0.5f), halfSize((max - min) * 0.5f)
+    {}
+
+    virtual Primitive* Clone() const
+    {
+        return new Box(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element)
+    {
+        //distances along the ray to each pair of slab planes
+        vec3 t0 = (min - ray.origin) * ray.invDirection;
+        vec3 t1 = (max - ray.origin) * ray.invDirection;
+        float tNear = t0.min(t1).maxComponent();
+        float tFar = t0.max(t1).minComponent();
+
+        //use the far side when the ray starts inside the box
+        intersection = tNear > 0.0001f ? tNear : tFar;
+        return tNear <= tFar && intersection > 0.0001f;
+    }
+
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element)
+    {
+        //the face hit is the axis where pos is furthest out relative to the box size
+        vec3 local = pos - center;
+        float x = fabsf(local.x / halfSize.x), y = fabsf(local.y / halfSize.y), z = fabsf(local.z / halfSize.z);
+        if (x > y && x > z)
+            return vec3(local.x > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f);
+        if (y > z)
+            return vec3(0.0f, local.y > 0.0f ? 1.0f : -1.0f, 0.0f);
+        return vec3(0.0f, 0.0f, local.z > 0.0f ? 1.0f : -1.0f);
+    }
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        bounds = AABB(min, max);
+        return true;
+    }
+};
+
+//Moller-Trumbore test against the triangle v1, v1+e1, v1+e2.
+inline bool RaycastTriangle(const Ray& ray, const vec3& v1, const vec3& e1, const vec3& e2, float& intersection)
+{
+    vec3 P = ray.direction.cross(e2);
+    float det = e1.dot(P);
+    if (det > -0.0001f && det < 0.0001f)
+        return false;
+    float invdet = 1.0f/det;
+
+    vec3 T = ray.origin - v1;
+    float u = T.dot(P) * invdet;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    vec3 Q = T.cross(e1);
+    float v = ray.direction.dot(Q) * invdet;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    intersection = e2.dot(Q) * invdet;
+    return intersection > 0.0001f;
+}
+
+//RaycastTriangle for eight rays at once. The intersection is only meaningful in lanes set in the returned mask.
+inline maskx8 RaycastTriangle(const RayPacket& rays, const vec3& v1, const vec3& e1, const vec3& e2, floatx8& intersection)
+{
+    vec3x8 edge1(e1), edge2(e2);
+    vec3x8 P = rays.direction.cross(edge2);
+    floatx8 det = edge1.dot(P);
+    maskx8 hit = (det <= -0.0001f) | (det >= 0.0001f);
+    floatx8 invdet = floatx8(1.0f) / det;
+
+    vec3x8 T = rays.origin - vec3x8(v1);
+    floatx8 u = T.dot(P) * invdet;
+    hit = hit & (u >= 0.0f) & (u <= 1.0f);
+
+    vec3x8 Q = T.cross(edge1);
+    floatx8 v = rays.direction.dot(Q) * invdet;
+    hit = hit & (v >= 0.0f) & (u + v <= 1.0f);
+
+    intersection = edge2.dot(Q) * invdet;
+    return hit & (intersection > 0.0001f);
+}
+
+struct Triangle : Primitive
+{
+    vec3 v1, e1, e2, N;
+
+    Triangle(vec3 v1, vec3 v2, vec3 v3) : v1(v1), e1(v2-v1), e2(v3-v1)
+    {
+        N = e1.cross(e2).normalize();
+    }
+
+    virtual Primitive* Clone() const
+    {
+        return new Triangle(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element)
+    {
+        return RaycastTriangle(ray, v1, e1, e2, intersection);
+    }
+
+    virtual maskx8 RaycastPacket(const RayPacket& rays, floatx8& intersection, uint64_t* elements)
+    {
+        return RaycastTriangle(rays, v1, e1, e2, intersection);
+    }
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        bounds = AABB(v1.min(v1 + e1).min(v1 + e2), v1.max(v1 + e1).max(v1 + e2));
+        return true;
+    }
+
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element)
+    {
+        return N;
+    }
+};
+
+//Lagae-Dutre test against the planar convex quad v00, v00+e01, v11, v00+e03. This is cheaper than
+//splitting it into two triangles as the second half is only tested when the ray misses the first,
+//and the plane distance is shared.
+inline bool RaycastQuad(const Ray& ray, const vec3& v00, const vec3& v11, const vec3& e01, const vec3& e03, float& intersection)
+{
+    //barycentric coordinates within the triangle v00, v10, v01
+    vec3 P = ray.direction.cross(e03);
+    float det = e01.dot(P);
+    if (det > -0.0001f && det < 0.0001f)
+        return false;
+    float invdet = 1.0f/det;
+
+    vec3 T = ray.origin - v00;
+    float alpha = T.dot(P) * invdet;
+    if (alpha < 0.0f)
+        return false;
+
+    vec3 Q = T.cross(e01);
+    float beta = ray.direction.dot(Q) * invdet;
+    if (beta < 0.0f)
+        return false;
+
+    //outside the first triangle, check the ray is inside the opposite one v11, v01, v10
+    if (alpha + beta > 1.0f)
+    {
+        vec3 e23 = v00 + e03 - v11;
+        vec3 e21 = v00 + e01 - v11;
+        vec3 P2 = ray.direction.cross(e21);
+        float det2 = e23.dot(P2);
+        if (det2 > -0.0001f && det2 < 0.0001f)
+            return false;
+        float invdet2 = 1.0f/det2;
+
+        vec3 T2 = ray.origin - v11;
+        float alpha2 = T2.dot(P2) * invdet2;
+        if (alpha2 < 0.0f)
+            return false;
+
+        vec3 Q2 = T2.cross(e23);
+        float beta2 = ray.direction.dot(Q2) * invdet2;
+        if (beta2 < 0.0f)
+            return false;
+    }
+
+    intersection = e03.dot(Q) * invdet;
+    return intersection > 0.0001f;
+}
+
+//a planar convex quad with corners in counter clockwise order, intersected with RaycastQuad.
+struct Quad : Primitive
+{
+    vec3 v00, v11, e01, e03, N;
+
+    Quad(vec3 a, vec3 b, vec3 c, vec3 d) : v00(a), v11(c), e01(b-a), e03(d-a)
+    {
+        N = e01.cross(e03).normalize();
+    }
+
+    //returns true if the corners form a planar convex quad, which is all this intersector handles.
+    static bool CanRepresent(const vec3& a, const vec3& b, const vec3& c, const vec3& d)
+    {
+        vec3 n = (b-a).cross(d-a);
+        float lenSq = n.lengthSq();
+        if (lenSq == 0.0f)
+            return false;
+
+        //the fourth corner must lie on the plane of the other three
+        vec3 diag = c-a;
+        float offPlane = n.dot(diag);
+        if (offPlane * offPlane > lenSq * diag.lengthSq() * 0.000001f)
+            return false;
+
+        //every corner must turn the same way
+        return (c-b).cross(a-b).dot(n) > 0.0f && (d-c).cross(b-c).dot(n) > 0.0f && (a-d).cross(c-d).dot(n) > 0.0f;
+    }
+
+    virtual Primitive* Clone() const
+    {
+        return new Quad(*this);
+    }
+
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element)
+    {
+        return RaycastQuad(ray, v00, v11, e01, e03, intersection);
+    }
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        vec3 v10 = v00 + e01, v01 = v00 + e03;
+        bounds = AABB(v00.min(v11).min(v10.min(v01)), v00.max(v11).max(v10.max(v01)));
+        return true;
+    }
+
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element)
+    {
+        return N;
+    }
+};
+
+#endif /* defined(__Raytracer__primitives__) */
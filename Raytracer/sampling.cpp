@@ -0,0 +1,63 @@
+//
+//  sampling.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "sampling.h"
+
+void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round<10; round++)
+    {
+        uint64_t product0 = (uint64_t)0xD2511F53 * c0, product1 = (uint64_t)0xCD9E8D57 * c2;
+        c0 = (uint32_t)(product1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)product1;
+        c2 = (uint32_t)(product0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)product0;
+
+        //the Weyl sequence steps of the golden ratio and sqrt(3) - 1
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+
+//the key's first word is fixed, the second counts the blocks of four numbers each sample has used
+static const uint32_t sampleSeed = 0x5eed1e55;
+
+SampleRandom::SampleRandom(int x, int y, int sample, int frame) : used(4)
+{
+    counter[0] = (uint32_t)x;
+    counter[1] = (uint32_t)y;
+    counter[2] = (uint32_t)sample;
+    counter[3] = (uint32_t)frame;
+    key[0] = sampleSeed;
+    key[1] = 0;
+}
+
+float SampleRandom::Next()
+{
+    if (used == 4)
+    {
+        philox(counter, key, block);
+        key[1]++;
+        used = 0;
+    }
+    //the top 24 bits, as many as a float holds exactly, so the result never rounds up to 1
+    return (block[used++] >> 8) * (1.0f / 16777216.0f);
+}
+
+void samplejitter(int x, int y, int sample, int frame, float& offsetX, float& offsetY)
+{
+    SampleRandom random(x, y, sample, frame);
+    offsetX = random.Next() - 0.5f;
+    offsetY = random.Next() - 0.5f;
+}
@@ -0,0 +1,37 @@
+//
+//  sampling.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__sampling__
+#define __Raytracer__sampling__
+
+#include <stdint.h>
+
+//Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"). Scrambles a 128 bit
+//counter under a 64 bit key into four random words, each counter giving its own numbers with nothing
+//carried over from the last call.
+void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]);
+
+//the random numbers for one sample of one pixel in one frame. They come from hashing the pixel, sample
+//and frame rather than from a generator the threads share or take turns on, so each sample gets the
+//same numbers whichever thread traces it and whatever has been traced before.
+struct SampleRandom
+{
+    SampleRandom(int x, int y, int sample, int frame);
+
+    //the next number in [0, 1)
+    float Next();
+
+private:
+    uint32_t counter[4], key[2], block[4];
+    int used;
+};
+
+//where in pixel x, y a sample goes, as offsets from its centre in [-0.5, 0.5)
+void samplejitter(int x, int y, int sample, int frame, float& offsetX, float& offsetY);
+
+#endif /* defined(__Raytracer__sampling__) */
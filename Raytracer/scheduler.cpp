@@ -0,0 +1,127 @@
+//
+//  scheduler.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "scheduler.h"
+#include <algorithm>
+
+TileScheduler::TileScheduler(int width, int height, int tileSize, int minTileSize, PixelOrder order) : width(width), height(height), tileSize(tileSize), minTileSize(minTileSize), predicted(false)
+{
+    blocksX = (width + minTileSize - 1) / minTileSize;
+    blocksY = (height + minTileSize - 1) / minTileSize;
+    curveorder(order, (width + tileSize - 1) / tileSize, (height + tileSize - 1) / tileSize, grid);
+}
+
+double TileScheduler::PredictCost(int x, int y, int w, int h) const
+{
+    double cost = 0.0;
+    for (int by = y / minTileSize; by < std::min((y + h + minTileSize - 1) / minTileSize, blocksY); by++)
+        for (int bx = x / minTileSize; bx < std::min((x + w + minTileSize - 1) / minTileSize, blocksX); bx++)
+            cost += blockCosts[by * blocksX + bx];
+    return cost;
+}
+
+//quarters the tile until each piece is predicted to take no more than target, or can't be split further
+void TileScheduler::Split(int x, int y, int w, int h, double target)
+{
+    if (x >= width || y >= height)
+        return;
+
+    double cost = PredictCost(x, y, w, h);
+    if (cost <= target || (w <= minTileSize && h <= minTileSize))
+    {
+        Tile tile = { x, y, w, h, cost };
+        tiles.push_back(tile);
+        return;
+    }
+
+    //halves stay a whole number of blocks so the costs line up with them next frame
+    int w0 = w <= minTileSize ? w : (w / 2 + minTileSize - 1) / minTileSize * minTileSize;
+    int h0 = h <= minTileSize ? h : (h / 2 + minTileSize - 1) / minTileSize * minTileSize;
+    Split(x, y, w0, h0, target);
+    if (w0 < w)
+        Split(x + w0, y, w - w0, h0, target);
+    if (h0 < h)
+    {
+        Split(x, y + h0, w0, h - h0, target);
+        if (w0 < w)
+            Split(x + w0, y + h0, w - w0, h - h0, target);
+    }
+}
+
+std::vector<Tile>& TileScheduler::Plan(int threadCount, bool uniform)
+{
+    tiles.clear();
+    predicted = !uniform && !blockCosts.empty();
+    if (!predicted)
+    {
+        for (uint32_t cell : grid)
+        {
+            Tile tile = { (int)(cell & 0xffff) * tileSize, (int)(cell >> 16) * tileSize, tileSize, tileSize, 0.0 };
+            tiles.push_back(tile);
+        }
+        return tiles;
+    }
+
+    //a few tiles' worth of work per thread leaves room to even out what the predictions get wrong
+    double total = PredictCost(0, 0, width, height);
+    for (uint32_t cell : grid)
+        Split((cell & 0xffff) * tileSize, (cell >> 16) * tileSize, tileSize, tileSize, total / (threadCount * 4));
+
+    //longest first, dealt round the workers. ThreadPool::Run gives each worker a contiguous block
+    //that it works through from the end, so each worker's tiles go into its block backwards.
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b) { return a.cost > b.cost; });
+    int count = (int)tiles.size();
+    std::vector<int> next(threadCount), start(threadCount);
+    for (int i = 0; i<threadCount; i++)
+    {
+        start[i] = count * i / threadCount;
+        next[i] = count * (i + 1) / threadCount - 1;
+    }
+
+    std::vector<Tile> dealt(count);
+    int worker = 0;
+    for (const Tile& tile : tiles)
+    {
+        while (next[worker] < start[worker])
+            worker = (worker + 1) % threadCount;
+        dealt[next[worker]--] = tile;
+        worker = (worker + 1) % threadCount;
+    }
+    tiles.swap(dealt);
+    return tiles;
+}
+
+void TileScheduler::Finish()
+{
+    blockCosts.assign(blocksX * blocksY, 0.0);
+    for (const Tile& tile : tiles)
+    {
+        //spread each tile's time evenly over the blocks it covers
+        int bx0 = tile.x / minTileSize, bx1 = std::min((tile.x + tile.width + minTileSize - 1) / minTileSize, blocksX);
+        int by0 = tile.y / minTileSize, by1 = std::min((tile.y + tile.height + minTileSize - 1) / minTileSize, blocksY);
+        double share = tile.cost / ((bx1 - bx0) * (by1 - by0));
+        for (int by = by0; by<by1; by++)
+            for (int bx = bx0; bx<bx1; bx++)
+                blockCosts[by * blocksX + bx] = share;
+    }
+}
+
+double TileScheduler::Makespan(int threadCount) const
+{
+    //the uniform grid goes in order, planned tiles longest first as the workers would take them
+    std::vector<double> costs;
+    for (const Tile& tile : tiles)
+        costs.push_back(tile.cost);
+    if (predicted)
+        std::sort(costs.begin(), costs.end(), [](double a, double b) { return a > b; });
+
+    std::vector<double> finish(threadCount, 0.0);
+    for (double cost : costs)
+        *std::min_element(finish.begin(), finish.end()) += cost;
+    return *std::max_element(finish.begin(), finish.end());
+}
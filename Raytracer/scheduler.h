@@ -0,0 +1,58 @@
+//
+//  scheduler.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__scheduler__
+#define __Raytracer__scheduler__
+
+#include "pixelorder.h"
+#include <vector>
+
+struct Tile
+{
+    int x, y, width, height;
+    //predicted seconds to render, then how long it actually took once it has been
+    double cost;
+};
+
+//Plans the tiles of each frame from how long the last frame's took. The first frame is a grid of
+//uniform tiles, so planning only helps from the second frame on and a single frame render never
+//uses it. After that, tiles predicted to cost more than a fair share of the frame are split
+//into quarters, down to the smallest tile size, and the tiles are handed out longest first so the
+//expensive ones don't end up as stragglers at the end of the frame. The grid is laid out in order, so
+//neighbouring tiles are dealt out together.
+struct TileScheduler
+{
+    //tileSize for the uniform tiles, minTileSize the smallest they can be split to
+    TileScheduler(int width, int height, int tileSize, int minTileSize, PixelOrder order = OrderScanline);
+
+    //the tiles for the next frame, laid out for ThreadPool::Run with threadCount workers. Uniform
+    //gives the plain grid whatever the costs are, for comparison.
+    std::vector<Tile>& Plan(int threadCount, bool uniform = false);
+    //takes the times recorded in the planned tiles' costs as the prediction for the next frame
+    void Finish();
+
+    //how long the planned tiles would take across threadCount workers each taking the next tile as
+    //soon as they're free, with the costs they have
+    double Makespan(int threadCount) const;
+
+private:
+    int width, height, tileSize, minTileSize;
+    int blocksX, blocksY;
+    //the uniform grid's tiles in order, as y << 16 | x in tiles
+    std::vector<uint32_t> grid;
+    //seconds per minTileSize block of the image, empty until a frame has finished
+    std::vector<double> blockCosts;
+    std::vector<Tile> tiles;
+    //whether tiles came from the costs rather than the uniform grid
+    bool predicted;
+
+    double PredictCost(int x, int y, int w, int h) const;
+    void Split(int x, int y, int w, int h, double target);
+};
+
+#endif /* defined(__Raytracer__scheduler__) */
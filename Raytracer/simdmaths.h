@@ -0,0 +1,345 @@
+//
+//  simdmaths.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__simdmaths__
+#define __Raytracer__simdmaths__
+
+#include "maths.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#else
+#include <stdint.h>
+#include <string.h>
+#endif
+
+//four floats in an SSE register, or a plain array without SSE. The helpers below are the only
+//code that differs between the two, vec4 and vec3a are built on top of them.
+#if defined(__SSE2__)
+
+typedef __m128 float4;
+
+inline float4 set4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline float4 splat4(float f) { return _mm_set1_ps(f); }
+inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+inline float4 min4(float4 a, float4 b) { return _mm_min_ps(a, b); }
+inline float4 max4(float4 a, float4 b) { return _mm_max_ps(a, b); }
+inline float4 sqrt4(float4 a) { return _mm_sqrt_ps(a); }
+inline float first4(float4 a) { return _mm_cvtss_f32(a); }
+inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline void store4(float* p, float4 a) { _mm_storeu_ps(p, a); }
+
+//a*b + c, rounded once when FMA is available
+inline float4 madd4(float4 a, float4 b, float4 c)
+{
+#if defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+//rotates the first three lanes, x y z w becomes y z x w
+inline float4 yzx4(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)); }
+
+//copies z into w, so a reduction over four lanes only sees the first three
+inline float4 xyzz4(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 0)); }
+
+//lanes x and y of a followed by lanes z and w of b
+template<int x, int y, int z, int w>
+inline float4 shuffle4(float4 a, float4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x)); }
+
+//sum, minimum and maximum of all four lanes, in every lane
+inline float4 hsum4(float4 a)
+{
+    a = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+inline float4 hmin4(float4 a)
+{
+    a = _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_min_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+inline float4 hmax4(float4 a)
+{
+    a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+//lane comparisons give masks with every bit of a lane set where they're true
+inline float4 cmplt4(float4 a, float4 b) { return _mm_cmplt_ps(a, b); }
+inline float4 cmple4(float4 a, float4 b) { return _mm_cmple_ps(a, b); }
+inline float4 cmpeq4(float4 a, float4 b) { return _mm_cmpeq_ps(a, b); }
+inline float4 cmpneq4(float4 a, float4 b) { return _mm_cmpneq_ps(a, b); }
+inline float4 and4(float4 a, float4 b) { return _mm_and_ps(a, b); }
+inline float4 or4(float4 a, float4 b) { return _mm_or_ps(a, b); }
+inline float4 andnot4(float4 a, float4 b) { return _mm_andnot_ps(a, b); }
+inline float4 ones4() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+
+//a where the mask is set, otherwise b
+inline float4 select4(float4 mask, float4 a, float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+//the sign bit of each lane, lane 0 in bit 0
+inline int bits4(float4 a) { return _mm_movemask_ps(a); }
+
+#else
+
+struct float4
+{
+    float v[4];
+};
+
+inline float4 set4(float x, float y, float z, float w) { float4 r = {{ x, y, z, w }}; return r; }
+inline float4 splat4(float f) { return set4(f, f, f, f); }
+inline float4 add4(float4 a, float4 b) { return set4(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+inline float4 sub4(float4 a, float4 b) { return set4(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+inline float4 mul4(float4 a, float4 b) { return set4(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]); }
+inline float4 div4(float4 a, float4 b) { return set4(a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]); }
+inline float4 min4(float4 a, float4 b) { return set4(a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]); }
+inline float4 max4(float4 a, float4 b) { return set4(a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]); }
+inline float4 sqrt4(float4 a) { return set4(sqrtf(a.v[0]), sqrtf(a.v[1]), sqrtf(a.v[2]), sqrtf(a.v[3])); }
+inline float first4(float4 a) { return a.v[0]; }
+inline float4 load4(const float* p) { return set4(p[0], p[1], p[2], p[3]); }
+inline void store4(float* p, float4 a) { memcpy(p, a.v, sizeof(a.v)); }
+inline float4 madd4(float4 a, float4 b, float4 c) { return add4(mul4(a, b), c); }
+inline float4 yzx4(float4 a) { return set4(a.v[1], a.v[2], a.v[0], a.v[3]); }
+inline float4 xyzz4(float4 a) { return set4(a.v[0], a.v[1], a.v[2], a.v[2]); }
+template<int x, int y, int z, int w>
+inline float4 shuffle4(float4 a, float4 b) { return set4(a.v[x], a.v[y], b.v[z], b.v[w]); }
+inline float4 hsum4(float4 a) { return splat4((a.v[0] + a.v[1]) + (a.v[2] + a.v[3])); }
+inline float4 hmin4(float4 a) { float x = a.v[0] < a.v[1] ? a.v[0] : a.v[1], y = a.v[2] < a.v[3] ? a.v[2] : a.v[3]; return splat4(x < y ? x : y); }
+inline float4 hmax4(float4 a) { float x = a.v[0] > a.v[1] ? a.v[0] : a.v[1], y = a.v[2] > a.v[3] ? a.v[2] : a.v[3]; return splat4(x > y ? x : y); }
+
+inline float maskbits(uint32_t bits) { float f; memcpy(&f, &bits, sizeof(f)); return f; }
+inline uint32_t lanebits(float f) { uint32_t bits; memcpy(&bits, &f, sizeof(bits)); return bits; }
+inline float4 cmp4(bool x, bool y, bool z, bool w) { return set4(maskbits(x ? ~0u : 0u), maskbits(y ? ~0u : 0u), maskbits(z ? ~0u : 0u), maskbits(w ? ~0u : 0u)); }
+inline float4 cmplt4(float4 a, float4 b) { return cmp4(a.v[0] < b.v[0], a.v[1] < b.v[1], a.v[2] < b.v[2], a.v[3] < b.v[3]); }
+inline float4 cmple4(float4 a, float4 b) { return cmp4(a.v[0] <= b.v[0], a.v[1] <= b.v[1], a.v[2] <= b.v[2], a.v[3] <= b.v[3]); }
+inline float4 cmpeq4(float4 a, float4 b) { return cmp4(a.v[0] == b.v[0], a.v[1] == b.v[1], a.v[2] == b.v[2], a.v[3] == b.v[3]); }
+inline float4 cmpneq4(float4 a, float4 b) { return cmp4(a.v[0] != b.v[0], a.v[1] != b.v[1], a.v[2] != b.v[2], a.v[3] != b.v[3]); }
+inline float4 and4(float4 a, float4 b) { float4 r; for (int i = 0; i<4; i++) r.v[i] = maskbits(lanebits(a.v[i]) & lanebits(b.v[i])); return r; }
+inline float4 or4(float4 a, float4 b) { float4 r; for (int i = 0; i<4; i++) r.v[i] = maskbits(lanebits(a.v[i]) | lanebits(b.v[i])); return r; }
+inline float4 andnot4(float4 a, float4 b) { float4 r; for (int i = 0; i<4; i++) r.v[i] = maskbits(~lanebits(a.v[i]) & lanebits(b.v[i])); return r; }
+inline float4 ones4() { return splat4(maskbits(~0u)); }
+inline float4 select4(float4 mask, float4 a, float4 b) { return or4(and4(mask, a), andnot4(mask, b)); }
+inline int bits4(float4 a) { int r = 0; for (int i = 0; i<4; i++) r |= (lanebits(a.v[i]) >> 31) << i; return r; }
+
+#endif
+
+//a 16 byte aligned four component vector with the same operators as vec3.
+struct alignas(16) vec4
+{
+    union
+    {
+        float4 m;
+        struct { float x, y, z, w; };
+    };
+
+    vec4() : m(splat4(0.0f))
+    {
+    }
+
+    vec4(float x, float y, float z, float w) : m(set4(x, y, z, w))
+    {
+    }
+
+    explicit vec4(float4 m) : m(m)
+    {
+    }
+
+    inline vec4 operator *(const float scalar) const
+    {
+        return vec4(mul4(m, splat4(scalar)));
+    }
+
+    inline vec4 operator +(const vec4& other) const
+    {
+        return vec4(add4(m, other.m));
+    }
+
+    inline vec4 operator *(const vec4& other) const
+    {
+        return vec4(mul4(m, other.m));
+    }
+
+    inline void operator +=(const vec4& other)
+    {
+        m = add4(m, other.m);
+    }
+
+    //returns this * scale + offset, rounded once when FMA is available.
+    inline vec4 madd(const vec4& scale, const vec4& offset) const
+    {
+        return vec4(madd4(m, scale.m, offset.m));
+    }
+
+    inline vec4 operator -(const vec4& other) const
+    {
+        return vec4(sub4(m, other.m));
+    }
+
+    //calculates the dot product of all four components.
+    inline float dot(const vec4& other) const
+    {
+        return first4(hsum4(mul4(m, other.m)));
+    }
+
+    inline float lengthSq() const
+    {
+        return dot(*this);
+    }
+
+    inline float length() const
+    {
+        return sqrtf(lengthSq());
+    }
+
+    //normalizes with one square root and a single divide of all components.
+    inline vec4 normalize() const
+    {
+        return vec4(div4(m, sqrt4(hsum4(mul4(m, m)))));
+    }
+
+    inline vec4 min(const vec4& other) const
+    {
+        return vec4(min4(m, other.m));
+    }
+
+    inline vec4 max(const vec4& other) const
+    {
+        return vec4(max4(m, other.m));
+    }
+
+    inline float minComponent() const
+    {
+        return first4(hmin4(m));
+    }
+
+    inline float maxComponent() const
+    {
+        return first4(hmax4(m));
+    }
+};
+
+//a 16 byte aligned 3D vector with the same operators as vec3. The unused fourth lane is kept
+//at zero, so dot products can sum all four lanes.
+struct alignas(16) vec3a
+{
+    union
+    {
+        float4 m;
+        struct { float x, y, z, w; };
+    };
+
+    vec3a() : m(splat4(0.0f))
+    {
+    }
+
+    vec3a(float x, float y, float z) : m(set4(x, y, z, 0.0f))
+    {
+    }
+
+    explicit vec3a(const vec3& v) : m(set4(v.x, v.y, v.z, 0.0f))
+    {
+    }
+
+    explicit vec3a(float4 m) : m(m)
+    {
+    }
+
+    inline vec3 toVec3() const
+    {
+        return vec3(x, y, z);
+    }
+
+    inline vec3a operator *(const float scalar) const
+    {
+        return vec3a(mul4(m, splat4(scalar)));
+    }
+
+    inline vec3a operator +(const vec3a& other) const
+    {
+        return vec3a(add4(m, other.m));
+    }
+
+    inline vec3a operator *(const vec3a& other) const
+    {
+        return vec3a(mul4(m, other.m));
+    }
+
+    inline void operator +=(const vec3a& other)
+    {
+        m = add4(m, other.m);
+    }
+
+    //returns this * scale + offset, rounded once when FMA is available.
+    inline vec3a madd(const vec3a& scale, const vec3a& offset) const
+    {
+        return vec3a(madd4(m, scale.m, offset.m));
+    }
+
+    inline vec3a operator -(const vec3a& other) const
+    {
+        return vec3a(sub4(m, other.m));
+    }
+
+    inline float dot(const vec3a& other) const
+    {
+        return first4(hsum4(mul4(m, other.m)));
+    }
+
+    inline float lengthSq() const
+    {
+        return dot(*this);
+    }
+
+    inline float length() const
+    {
+        return sqrtf(lengthSq());
+    }
+
+    //normalizes with one square root and a single divide of all components.
+    inline vec3a normalize() const
+    {
+        return vec3a(div4(m, sqrt4(hsum4(mul4(m, m)))));
+    }
+
+    //cross product from one rotated product, (a * b.yzx - a.yzx * b).yzx
+    inline vec3a cross(const vec3a& other) const
+    {
+        float4 c = sub4(mul4(m, yzx4(other.m)), mul4(yzx4(m), other.m));
+        return vec3a(yzx4(c));
+    }
+
+    inline vec3a min(const vec3a& other) const
+    {
+        return vec3a(min4(m, other.m));
+    }
+
+    inline vec3a max(const vec3a& other) const
+    {
+        return vec3a(max4(m, other.m));
+    }
+
+    inline float minComponent() const
+    {
+        return first4(hmin4(xyzz4(m)));
+    }
+
+    inline float maxComponent() const
+    {
+        return first4(hmax4(xyzz4(m)));
+    }
+};
+
+#endif /* defined(__Raytracer__simdmaths__) */
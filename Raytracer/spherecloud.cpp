@@ -0,0 +1,163 @@
+//
+//  spherecloud.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "spherecloud.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+SphereCloud::SphereCloud(const std::vector<vec3>& centers, const std::vector<float>& radii) : count(centers.size()), radius(0.0f)
+{
+    Build(centers, radii);
+}
+
+SphereCloud::SphereCloud(const std::vector<vec3>& centers, float radius) : count(centers.size()), radius(radius)
+{
+    Build(centers, std::vector<float>());
+}
+
+void SphereCloud::Build(const std::vector<vec3>& centers, const std::vector<float>& radii)
+{
+    {
+        std::vector<AABB> bounds;
+        bounds.reserve(count);
+        for (size_t i = 0; i<count; i++)
+        {
+            float r = radii.empty() ? radius : radii[i];
+            bounds.push_back(AABB(centers[i] - vec3(r, r, r), centers[i] + vec3(r, r, r)));
+        }
+        bvh.Build(bounds, leafSize);
+    }
+
+    //store the spheres in leaf order, so leaves index them directly and the item list can go
+    size_t padded = count + leafSize;
+    x.resize(padded);
+    y.resize(padded);
+    z.resize(padded);
+    if (!radii.empty())
+        this->radii.resize(padded);
+    for (size_t i = 0; i<count; i++)
+    {
+        uint32_t item = bvh.items[i];
+        x[i] = centers[item].x;
+        y[i] = centers[item].y;
+        z[i] = centers[item].z;
+        if (!radii.empty())
+            this->radii[i] = radii[item];
+    }
+    std::vector<uint32_t>().swap(bvh.items);
+}
+
+size_t SphereCloud::MemoryUsage() const
+{
+    return (x.size() + y.size() + z.size() + radii.size()) * sizeof(float) + bvh.MemoryUsage();
+}
+
+#if defined(__AVX__)
+
+//intersects the ray with eight spheres, writing FLT_MAX for the ones it misses.
+static inline void intersect8(const Ray& ray, const float* cx, const float* cy, const float* cz, const float* cr, float radius, float* t)
+{
+    __m256 ox = _mm256_sub_ps(_mm256_loadu_ps(cx), _mm256_set1_ps(ray.origin.x));
+    __m256 oy = _mm256_sub_ps(_mm256_loadu_ps(cy), _mm256_set1_ps(ray.origin.y));
+    __m256 oz = _mm256_sub_ps(_mm256_loadu_ps(cz), _mm256_set1_ps(ray.origin.z));
+    __m256 r = cr ? _mm256_loadu_ps(cr) : _mm256_set1_ps(radius);
+
+    __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, _mm256_set1_ps(ray.direction.x)), _mm256_mul_ps(oy, _mm256_set1_ps(ray.direction.y))), _mm256_mul_ps(oz, _mm256_set1_ps(ray.direction.z)));
+    __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz)), _mm256_mul_ps(r, r));
+    __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+    __m256 s = _mm256_sqrt_ps(_mm256_max_ps(disc, _mm256_setzero_ps()));
+
+    //take the near intersection unless it's behind the ray origin
+    __m256 eps = _mm256_set1_ps(0.0001f);
+    __m256 tNear = _mm256_sub_ps(b, s);
+    __m256 hit = _mm256_blendv_ps(_mm256_add_ps(b, s), tNear, _mm256_cmp_ps(tNear, eps, _CMP_GT_OQ));
+    __m256 valid = _mm256_and_ps(_mm256_cmp_ps(disc, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_cmp_ps(hit, eps, _CMP_GT_OQ));
+    _mm256_storeu_ps(t, _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), hit, valid));
+}
+
+#elif defined(__SSE2__)
+
+//intersects the ray with four spheres, writing FLT_MAX for the ones it misses.
+static inline void intersect4(const Ray& ray, const float* cx, const float* cy, const float* cz, const float* cr, float radius, float* t)
+{
+    __m128 ox = _mm_sub_ps(_mm_loadu_ps(cx), _mm_set1_ps(ray.origin.x));
+    __m128 oy = _mm_sub_ps(_mm_loadu_ps(cy), _mm_set1_ps(ray.origin.y));
+    __m128 oz = _mm_sub_ps(_mm_loadu_ps(cz), _mm_set1_ps(ray.origin.z));
+    __m128 r = cr ? _mm_loadu_ps(cr) : _mm_set1_ps(radius);
+
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, _mm_set1_ps(ray.direction.x)), _mm_mul_ps(oy, _mm_set1_ps(ray.direction.y))), _mm_mul_ps(oz, _mm_set1_ps(ray.direction.z)));
+    __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz)), _mm_mul_ps(r, r));
+    __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), c);
+    __m128 s = _mm_sqrt_ps(_mm_max_ps(disc, _mm_setzero_ps()));
+
+    //take the near intersection unless it's behind the ray origin
+    __m128 eps = _mm_set1_ps(0.0001f);
+    __m128 tNear = _mm_sub_ps(b, s);
+    __m128 useNear = _mm_cmpgt_ps(tNear, eps);
+    __m128 hit = _mm_or_ps(_mm_and_ps(useNear, tNear), _mm_andnot_ps(useNear, _mm_add_ps(b, s)));
+    __m128 valid = _mm_and_ps(_mm_cmpge_ps(disc, _mm_setzero_ps()), _mm_cmpgt_ps(hit, eps));
+    _mm_storeu_ps(t, _mm_or_ps(_mm_and_ps(valid, hit), _mm_andnot_ps(valid, _mm_set1_ps(FLT_MAX))));
+}
+
+#endif
+
+bool SphereCloud::RaycastLeaf(const Ray& ray, uint32_t first, uint32_t count, float& tMax, uint64_t& element) const
+{
+    const float* cx = &x[first];
+    const float* cy = &y[first];
+    const float* cz = &z[first];
+    const float* cr = radii.empty() ? nullptr : &radii[first];
+
+    //all eight lanes are tested at once, lanes past the end of the leaf are ignored after
+    float t[leafSize];
+#if defined(__AVX__)
+    intersect8(ray, cx, cy, cz, cr, radius, t);
+#elif defined(__SSE2__)
+    intersect4(ray, cx, cy, cz, cr, radius, t);
+    intersect4(ray, cx + 4, cy + 4, cz + 4, cr ? cr + 4 : nullptr, radius, t + 4);
+#else
+    for (int i = 0; i<leafSize; i++)
+    {
+        float ox = cx[i] - ray.origin.x, oy = cy[i] - ray.origin.y, oz = cz[i] - ray.origin.z;
+        float r = cr ? cr[i] : radius;
+        float b = ox*ray.direction.x + oy*ray.direction.y + oz*ray.direction.z;
+        float disc = b*b - (ox*ox + oy*oy + oz*oz - r*r);
+        float s = sqrtf(fmaxf(disc, 0.0f));
+        float hit = b - s > 0.0001f ? b - s : b + s;
+        t[i] = disc >= 0.0f && hit > 0.0001f ? hit : FLT_MAX;
+    }
+#endif
+
+    bool found = false;
+    for (uint32_t i = 0; i<count; i++)
+    {
+        if (t[i] < tMax)
+        {
+            tMax = t[i];
+            element = first + i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool SphereCloud::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    float tMax = FLT_MAX;
+    bool hit = bvh.Traverse(ray, tMax, [&](uint32_t first, uint32_t count, float& t) { return RaycastLeaf(ray, first, count, t, element); });
+
+    intersection = tMax;
+    return hit;
+}
+
+vec3 SphereCloud::GetNormal(const vec3& pos, uint64_t element)
+{
+    return (pos - vec3(x[element], y[element], z[element])).normalize();
+}
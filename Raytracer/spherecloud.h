@@ -0,0 +1,60 @@
+//
+//  spherecloud.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__spherecloud__
+#define __Raytracer__spherecloud__
+
+#include "bvh.h"
+
+//millions of spheres sharing one material, for particles and point clouds. Centres and radii are
+//kept as separate float arrays in BVH leaf order so each leaf of up to eight spheres is tested with
+//one eight wide SIMD test, and a cloud with a shared radius doesn't store radii at all.
+struct SphereCloud : Primitive
+{
+    SphereCloud(const std::vector<vec3>& centers, const std::vector<float>& radii);
+    SphereCloud(const std::vector<vec3>& centers, float radius);
+
+    virtual Primitive* Clone() const
+    {
+        return new SphereCloud(*this);
+    }
+
+    //the element returned is the index of the sphere hit in leaf order
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        if (bvh.nodes.empty())
+            return false;
+        bounds = bvh.nodes[0].bounds;
+        return true;
+    }
+
+    //bytes used by the sphere arrays and the hierarchy.
+    size_t MemoryUsage() const;
+
+    size_t SphereCount() const
+    {
+        return count;
+    }
+
+private:
+    static const int leafSize = 8;
+
+    size_t count;
+    float radius;//used when radii is empty
+    std::vector<float> x, y, z, radii;//padded by a leaf so the last leaf can always load eight lanes
+    BVH bvh;
+
+    void Build(const std::vector<vec3>& centers, const std::vector<float>& radii);
+
+    bool RaycastLeaf(const Ray& ray, uint32_t first, uint32_t count, float& tMax, uint64_t& element) const;
+};
+
+#endif /* defined(__Raytracer__spherecloud__) */
@@ -85,6 +85,9 @@ void texturerenderer_setup()
     glActiveTexture(GL_TEXTURE0);
     glUniform1i(glGetUniformLocation(program, "tex"), 0);
     glBindTexture(GL_TEXTURE_2D, texture);
+    
+    //colors are tightly packed, rows of an odd width don't start on four byte boundaries
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 }
 
 void texturerenderer_displaytexture(color* pixels, int w, int h)
@@ -92,6 +95,13 @@ void texturerenderer_displaytexture(color* pixels, int w, int h)
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
 }
 
+void texturerenderer_updatetexture(const color* pixels, int width, int x, int y, int w, int h)
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels + y*width + x);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
 void texturerenderer_draw()
 {
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
@@ -17,6 +17,9 @@ struct color {
 
 void texturerenderer_setup();
 void texturerenderer_displaytexture(color* pixels, int w, int h);
+//copies the w by h rectangle at x, y of pixels, an image width pixels across, into the texture that
+//texturerenderer_displaytexture made
+void texturerenderer_updatetexture(const color* pixels, int width, int x, int y, int w, int h);
 void texturerenderer_draw();
 
 #endif /* defined(__Raytracer__texturerenderer__) */
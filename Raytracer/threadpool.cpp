@@ -0,0 +1,266 @@
+//
+//  threadpool.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "threadpool.h"
+#include "numatopology.h"
+#include <algorithm>
+
+//the node of the worker on this thread, set while it's working for a NUMA pool
+static thread_local int currentNode = 0;
+//the pool this thread is a worker of and which one it is, so tasks it starts go on its own deque
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = 0;
+//the victim picking state of a thread from outside the pool, which can't share worker 0's with the
+//other threads outside it
+static thread_local uint32_t outsideRandom = 0;
+
+ThreadPool::ThreadPool(int threadCount, bool numa) : numa(numa), queued(0), stopping(false)
+{
+    if (threadCount <= 0)
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+    const NumaTopology& topology = numatopology();
+    int nodeCount = topology.NodeCount();
+    for (int i = 0; i<threadCount; i++)
+    {
+        workers.push_back(new Worker());
+        workers.back()->random = 2654435761u * (i + 1);
+        workers.back()->cpu = -1;
+        workers.back()->node = 0;
+        if (numa)
+        {
+            //worker i goes to node i * nodeCount / threadCount, taking that node's cpus in turn
+            int node = i * nodeCount / threadCount;
+            int first = (node * threadCount + nodeCount - 1) / nodeCount;
+            const std::vector<int>& cpus = topology.Cpus(node);
+            workers.back()->cpu = cpus[(i - first) % cpus.size()];
+            workers.back()->node = node;
+        }
+    }
+
+    //worker 0 is whichever thread calls Run from outside the pool, except in a NUMA pool where it has
+    //to stay on its cpu
+    for (int i = numa ? 0 : 1; i<threadCount; i++)
+        threads.push_back(std::thread(&ThreadPool::WorkerThread, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+    for (Worker* worker : workers)
+        delete worker;
+}
+
+int ThreadPool::CurrentNode()
+{
+    return currentNode;
+}
+
+ThreadPool::Worker& ThreadPool::CallingWorker()
+{
+    return *workers[currentPool == this ? currentWorker : 0];
+}
+
+void ThreadPool::Push(Worker& worker, const Task& task)
+{
+    std::lock_guard<std::mutex> guard(worker.lock);
+    worker.tasks.push_back(task);
+    queued++;
+}
+
+//taking the lock orders this after any sleeper's last check, so the wake up can't be missed
+void ThreadPool::Notify()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wake.notify_all();
+}
+
+void ThreadPool::Run(int count, const std::function<void(int)>& task)
+{
+    if (count <= 0)
+        return;
+
+    std::atomic<int> remaining(count);
+    int workerCount = (int)workers.size();
+    for (int i = 0; i<workerCount; i++)
+    {
+        for (int index = count * i / workerCount; index < count * (i + 1) / workerCount; index++)
+            Push(*workers[i], { &task, index, &remaining });
+    }
+    Notify();
+
+    WorkUntil(CallingWorker(), remaining);
+}
+
+//the owner works back to front through its deque, so thieves taking from the front rarely contend with it
+bool ThreadPool::Pop(Worker& worker, Task& task)
+{
+    std::lock_guard<std::mutex> guard(worker.lock);
+    if (worker.tasks.empty())
+        return false;
+    task = worker.tasks.back();
+    worker.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool ThreadPool::Steal(Worker& thief, Task& task)
+{
+    int workerCount = (int)workers.size();
+
+    //xorshift, each thread has its own state so picking a victim needs no synchronisation
+    uint32_t& random = currentPool == this ? thief.random : outsideRandom;
+    if (random == 0)
+        random = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+
+    //start from a random victim and go round the rest, so an empty pool is noticed in one pass. In a
+    //NUMA pool the first pass only takes from the thief's own node, whose tasks' data is likely local.
+    int first = (int)(random % workerCount);
+    for (int pass = numa ? 0 : 1; pass<2; pass++)
+    {
+        for (int i = 0; i<workerCount; i++)
+        {
+            Worker& victim = *workers[(first + i) % workerCount];
+            if (&victim == &thief || (pass == 0 && victim.node != thief.node))
+                continue;
+
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                queued--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Execute(const Task& task)
+{
+    (*task.function)(task.index);
+    if (--*task.remaining == 0)
+        Notify();
+}
+
+//runs tasks until remaining reaches zero, sleeping only when there's nothing queued to help with.
+//Threads from outside a NUMA pool only wait, they'd run their tasks away from the tasks' nodes.
+void ThreadPool::WorkUntil(Worker& worker, std::atomic<int>& remaining)
+{
+    if (numa && currentPool != this)
+    {
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [&]() { return remaining == 0; });
+        return;
+    }
+
+    while (remaining > 0)
+    {
+        Task task;
+        if (Pop(worker, task) || Steal(worker, task))
+        {
+            Execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [&]() { return remaining == 0 || queued > 0; });
+    }
+}
+
+void ThreadPool::WorkerThread(int index)
+{
+    currentPool = this;
+    currentWorker = index;
+    if (numa)
+    {
+        pinthread(workers[index]->cpu);
+        currentNode = workers[index]->node;
+    }
+
+    Worker& worker = *workers[index];
+    while (true)
+    {
+        Task task;
+        if (Pop(worker, task) || Steal(worker, task))
+        {
+            Execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this]() { return stopping || queued > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+static std::atomic<ThreadPool*> sharedPool(nullptr);
+static std::mutex sharedPoolLock;
+
+ThreadPool& taskpool()
+{
+    ThreadPool* pool = sharedPool;
+    if (!pool)
+    {
+        std::lock_guard<std::mutex> guard(sharedPoolLock);
+        if (!sharedPool)
+            sharedPool = new ThreadPool();
+        pool = sharedPool;
+    }
+    return *pool;
+}
+
+ThreadPool* settaskpool(ThreadPool* pool)
+{
+    std::lock_guard<std::mutex> guard(sharedPoolLock);
+    return sharedPool.exchange(pool);
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool(pool), remaining(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    Wait();
+}
+
+void TaskGroup::Run(const std::function<void()>& task)
+{
+    functions.push_back([task](int) { task(); });
+    remaining++;
+    pool.Push(pool.CallingWorker(), { &functions.back(), 0, &remaining });
+    pool.Notify();
+}
+
+void TaskGroup::Wait()
+{
+    pool.WorkUntil(pool.CallingWorker(), remaining);
+}
+
+void parallelfor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+    size_t chunks = last > first ? (last - first + grain - 1) / grain : 0;
+    taskpool().Run((int)chunks, [&](int chunk) {
+        size_t begin = first + chunk * grain;
+        body(begin, std::min(begin + grain, last));
+    });
+}
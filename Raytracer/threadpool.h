@@ -0,0 +1,149 @@
+//
+//  threadpool.h
+//  Raytracer
+//
+//  Created by Alex Parker on 19/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__threadpool__
+#define __Raytracer__threadpool__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+//A fixed set of worker threads with a deque of tasks each. Each worker takes tasks from the back of
+//its own deque and, once that runs dry, steals from the front of a randomly picked victim's, so
+//workers that finish their share early take over the tail of a slower one's instead of sitting idle.
+//Tasks can start more tasks and wait for them. A thread waiting on tasks runs queued ones, its own
+//or stolen, until they're done, so nested fork-join never ties up a worker doing nothing.
+//
+//Any thread can use a pool. Threads from outside it run tasks as worker 0, each with its own state for
+//picking victims.
+//
+//A NUMA pool pins each worker to a cpu, spreading them evenly over the nodes in numatopology() with
+//each node's workers numbered together. Thieves try the workers on their own node before the rest.
+//Worker 0 gets a thread of its own too, threads from outside only wait for their tasks, so nothing
+//has to be pinned and unpinned as they come and go.
+struct ThreadPool
+{
+    //threadCount workers counting the thread that calls Run outside a NUMA pool, 0 for one per
+    //hardware thread
+    explicit ThreadPool(int threadCount = 0, bool numa = false);
+    ~ThreadPool();
+
+    int ThreadCount() const
+    {
+        return (int)workers.size();
+    }
+
+    //the node worker runs on, always 0 outside a NUMA pool
+    int WorkerNode(int worker) const
+    {
+        return workers[worker]->node;
+    }
+
+    //the node of the worker running the calling task, 0 on threads that aren't a NUMA pool's workers
+    static int CurrentNode();
+
+    //calls task(i) for every i below count across the workers, returning once they have all finished.
+    //Worker w is dealt the indices from count*w/n up to count*(w+1)/n and runs them from the last,
+    //thieves take the first, so callers can lay out indices to control what runs first. Threads
+    //outside the pool are worker 0, or just wait in a NUMA pool.
+    void Run(int count, const std::function<void(int)>& task);
+
+private:
+    friend struct TaskGroup;
+
+    struct Task
+    {
+        const std::function<void(int)>* function;
+        int index;
+        //counts down as the tasks of a Run or TaskGroup finish
+        std::atomic<int>* remaining;
+    };
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        uint32_t random;
+        //the cpu it's pinned to, -1 if it isn't, and that cpu's node
+        int cpu, node;
+    };
+
+    std::vector<Worker*> workers;
+    std::vector<std::thread> threads;
+    bool numa;
+
+    //idle workers and waiting threads sleep on wake until a task is queued or the ones they're
+    //waiting for have finished
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> queued;
+    bool stopping;
+
+    Worker& CallingWorker();
+    void Push(Worker& worker, const Task& task);
+    void Notify();
+    bool Pop(Worker& worker, Task& task);
+    bool Steal(Worker& thief, Task& task);
+    void Execute(const Task& task);
+    void WorkUntil(Worker& worker, std::atomic<int>& remaining);
+    void WorkerThread(int index);
+};
+
+//the pool every part of the program shares, so loading, building and rendering never start threads
+//of their own. It's made with one worker per hardware thread the first time it's asked for, unless
+//settaskpool has given it another. settaskpool returns the pool it replaces.
+ThreadPool& taskpool();
+ThreadPool* settaskpool(ThreadPool* pool);
+
+//Runs tasks that aren't the iterations of a loop side by side. Run queues a task on the calling
+//worker's deque and Wait runs tasks until all of the group's have finished, which the destructor
+//also does. A group belongs to the thread that made it, only that thread can add to it.
+struct TaskGroup
+{
+    explicit TaskGroup(ThreadPool& pool = taskpool());
+    ~TaskGroup();
+
+    void Run(const std::function<void()>& task);
+    void Wait();
+
+private:
+    ThreadPool& pool;
+    //a deque so the functions don't move while the workers hold pointers to them
+    std::deque<std::function<void(int)>> functions;
+    std::atomic<int> remaining;
+};
+
+//calls body(begin, end) over [first, last) in chunks of grain on the shared pool, returning once
+//they're all done
+void parallelfor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+//maps each chunk of grain of [first, last) to a value with map(begin, end), then folds the values
+//together from the left with combine, so the result doesn't depend on how the chunks were scheduled
+template<typename T, typename Map, typename Combine>
+T parallelreduce(size_t first, size_t last, size_t grain, const T& identity, const Map& map, const Combine& combine)
+{
+    size_t chunks = last > first ? (last - first + grain - 1) / grain : 0;
+    std::vector<T> values(chunks, identity);
+    taskpool().Run((int)chunks, [&](int chunk) {
+        size_t begin = first + chunk * grain;
+        values[chunk] = map(begin, std::min(begin + grain, last));
+    });
+
+    T result = identity;
+    for (const T& value : values)
+        result = combine(result, value);
+    return result;
+}
+
+#endif /* defined(__Raytracer__threadpool__) */
@@ -0,0 +1,272 @@
+//
+//  voxeloctree.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "voxeloctree.h"
+#include <stdint.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+//spreads the bits of v out so there are two zero bits between each.
+static uint64_t spreadbits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+//checks resolution is a power of two from 2, the grid of a single leaf node, up to what Voxel's
+//coordinates can span and that every voxel is inside the grid, printing what's wrong as coming from name
+static bool validgrid(const char* name, int64_t resolution, const std::vector<Voxel>& voxels)
+{
+    if (resolution < 2 || resolution > 65536 || (resolution & (resolution - 1)) != 0)
+    {
+        fprintf(stderr, "%s: the resolution %lld isn't a power of two from 2 to 65536\n", name, (long long)resolution);
+        return false;
+    }
+    for (size_t i = 0; i<voxels.size(); i++)
+    {
+        const Voxel& v = voxels[i];
+        if (v.x >= resolution || v.y >= resolution || v.z >= resolution)
+        {
+            fprintf(stderr, "%s: voxel %zu at %d, %d, %d is outside the %lld^3 grid\n", name, i, v.x, v.y, v.z, (long long)resolution);
+            return false;
+        }
+    }
+    return true;
+}
+
+VoxelOctree::VoxelOctree(vec3 origin, float voxelSize, int resolution, const std::vector<Voxel>& voxels) :
+    origin(origin), voxelSize(voxelSize), resolution(resolution), depth(0)
+{
+    if (!validgrid("VoxelOctree", resolution, voxels))
+    {
+        this->resolution = 0;
+        return;
+    }
+    while ((1 << depth) < resolution)
+        depth++;
+
+    //sorting by morton code puts the children of every node next to each other
+    std::vector<uint64_t> codes;
+    codes.reserve(voxels.size());
+    for (const Voxel& v : voxels)
+        codes.push_back(spreadbits(v.x) | spreadbits(v.y) << 1 | spreadbits(v.z) << 2);
+    std::sort(codes.begin(), codes.end());
+    codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+    if (codes.empty())
+        return;
+
+    //build one level at a time from the bottom up, grouping the codes that share a parent
+    std::vector<std::vector<Node>> levels(depth);
+    for (int level = depth - 1; level >= 0; level--)
+    {
+        std::vector<uint64_t> parents;
+        for (size_t i = 0; i<codes.size();)
+        {
+            Node node = { (uint32_t)i, 0 };
+            uint64_t parent = codes[i] >> 3;
+            for (; i<codes.size() && codes[i] >> 3 == parent; i++)
+                node.childMask |= 1 << (codes[i] & 7);
+
+            levels[level].push_back(node);
+            parents.push_back(parent);
+        }
+        codes.swap(parents);
+    }
+
+    //then lay the levels out root first, making child indices absolute
+    size_t nodeCount = 0;
+    for (const std::vector<Node>& level : levels)
+        nodeCount += level.size();
+    if (nodeCount > UINT32_MAX)
+    {
+        fprintf(stderr, "VoxelOctree: %zu nodes are more than 32 bit child indices can refer to\n", nodeCount);
+        this->resolution = 0;
+        return;
+    }
+    nodes.reserve(nodeCount);
+    
+    size_t levelStart = 0;
+    for (int level = 0; level<depth; level++)
+    {
+        size_t childStart = levelStart + levels[level].size();
+        for (Node& node : levels[level])
+        {
+            if (level + 1 < depth)
+                node.firstChild += (uint32_t)childStart;
+            nodes.push_back(node);
+        }
+        levelStart = childStart;
+        std::vector<Node>().swap(levels[level]);
+    }
+}
+
+VoxelOctree* VoxelOctree::Load(const char* file, vec3 origin, float voxelSize)
+{
+    FILE* f = fopen(file, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "%s: can't be opened\n", file);
+        return nullptr;
+    }
+
+    char magic[4];
+    uint32_t resolution;
+    uint64_t count;
+    std::vector<Voxel> voxels;
+    bool ok = fread(magic, 4, 1, f) == 1 && memcmp(magic, "SVOX", 4) == 0 &&
+        fread(&resolution, sizeof(resolution), 1, f) == 1 &&
+        fread(&count, sizeof(count), 1, f) == 1;
+    if (!ok)
+        fprintf(stderr, "%s: isn't a voxel file\n", file);
+
+    //the count is checked against what's left of the file before anything is allocated for it
+    if (ok)
+    {
+        long start = ftell(f);
+        ok = fseek(f, 0, SEEK_END) == 0;
+        uint64_t room = ok ? (uint64_t)(ftell(f) - start) / sizeof(Voxel) : 0;
+        ok = ok && fseek(f, start, SEEK_SET) == 0;
+        if (ok && count > room)
+        {
+            fprintf(stderr, "%s: says it has %llu voxels but there's only room for %llu\n", file, (unsigned long long)count, (unsigned long long)room);
+            ok = false;
+        }
+    }
+    if (ok)
+    {
+        voxels.resize(count);
+        ok = fread(voxels.data(), sizeof(Voxel), count, f) == count;
+        if (!ok)
+            fprintf(stderr, "%s: couldn't read its voxels\n", file);
+    }
+    fclose(f);
+
+    if (!ok || !validgrid(file, resolution, voxels))
+        return nullptr;
+    return new VoxelOctree(origin, voxelSize, resolution, voxels);
+}
+
+bool VoxelOctree::Save(const char* file, int resolution, const std::vector<Voxel>& voxels)
+{
+    FILE* f = fopen(file, "wb");
+    if (!f)
+        return false;
+
+    uint32_t res = resolution;
+    uint64_t count = voxels.size();
+    bool ok = fwrite("SVOX", 4, 1, f) == 1 &&
+        fwrite(&res, sizeof(res), 1, f) == 1 &&
+        fwrite(&count, sizeof(count), 1, f) == 1 &&
+        fwrite(voxels.data(), sizeof(Voxel), count, f) == count;
+    fclose(f);
+    return ok;
+}
+
+size_t VoxelOctree::MemoryUsage() const
+{
+    return nodes.size() * sizeof(Node);
+}
+
+//Revelles et al. parametric traversal. The ray has been mirrored so every direction component is
+//positive, mirror holds the flipped axes so octant i of the mirrored ray is child i ^ mirror.
+bool VoxelOctree::Traverse(uint32_t index, int level, vec3 t0, vec3 t1, int mirror, float& intersection, int& axis) const
+{
+    if (t1.x < 0.0f || t1.y < 0.0f || t1.z < 0.0f)
+        return false;
+
+    const Node& node = nodes[index];
+    vec3 tm = (t0 + t1) * 0.5f;
+
+    //the first octant entered is past the midplanes crossed before the ray enters the node
+    float tEnter = t0.maxComponent();
+    int octant = (tm.x < tEnter ? 1 : 0) | (tm.y < tEnter ? 2 : 0) | (tm.z < tEnter ? 4 : 0);
+    while (octant < 8)
+    {
+        vec3 c0(octant & 1 ? tm.x : t0.x, octant & 2 ? tm.y : t0.y, octant & 4 ? tm.z : t0.z);
+        vec3 c1(octant & 1 ? t1.x : tm.x, octant & 2 ? t1.y : tm.y, octant & 4 ? t1.z : tm.z);
+
+        int child = octant ^ mirror;
+        if (node.childMask & (1 << child))
+        {
+            if (level + 1 == depth)
+            {
+                //a solid voxel, the face hit is the last slab the ray entered
+                float t = c0.maxComponent();
+                if (t > 0.0001f && t <= c1.minComponent())
+                {
+                    intersection = t;
+                    axis = c0.x == t ? 0 : (c0.y == t ? 1 : 2);
+                    return true;
+                }
+            }
+            else
+            {
+                uint32_t childIndex = node.firstChild + __builtin_popcount(node.childMask & ((1 << child) - 1));
+                if (Traverse(childIndex, level + 1, c0, c1, mirror, intersection, axis))
+                    return true;
+            }
+        }
+
+        //step to the neighbouring octant across whichever plane the ray leaves through first
+        if (c1.x <= c1.y && c1.x <= c1.z)
+            octant = octant & 1 ? 8 : octant | 1;
+        else if (c1.y <= c1.z)
+            octant = octant & 2 ? 8 : octant | 2;
+        else
+            octant = octant & 4 ? 8 : octant | 4;
+    }
+    return false;
+}
+
+bool VoxelOctree::Raycast(const Ray& ray, float& intersection, uint64_t& element)
+{
+    if (nodes.empty())
+        return false;
+
+    //mirror the ray about the centre of the octree so it travels in the positive direction on every axis
+    float size = resolution * voxelSize;
+    vec3 center = origin + vec3(size, size, size) * 0.5f;
+    vec3 o = ray.origin, d = ray.direction;
+    int mirror = 0;
+    if (d.x < 0.0f) { o.x = center.x * 2.0f - o.x; d.x = -d.x; mirror |= 1; }
+    if (d.y < 0.0f) { o.y = center.y * 2.0f - o.y; d.y = -d.y; mirror |= 2; }
+    if (d.z < 0.0f) { o.z = center.z * 2.0f - o.z; d.z = -d.z; mirror |= 4; }
+
+    //keep the slab distances finite for axis aligned rays
+    vec3 inv(1.0f / fmaxf(d.x, 1e-20f), 1.0f / fmaxf(d.y, 1e-20f), 1.0f / fmaxf(d.z, 1e-20f));
+    vec3 t0 = (origin - o) * inv;
+    vec3 t1 = (origin + vec3(size, size, size) - o) * inv;
+    if (t0.maxComponent() >= t1.minComponent())
+        return false;
+
+    int axis;
+    if (!Traverse(0, 0, t0, t1, mirror, intersection, axis))
+        return false;
+
+    //the face points back along the original ray
+    float dir = axis == 0 ? ray.direction.x : (axis == 1 ? ray.direction.y : ray.direction.z);
+    element = axis * 2 + (dir < 0.0f ? 1 : 0);
+    return true;
+}
+
+vec3 VoxelOctree::GetNormal(const vec3& pos, uint64_t element)
+{
+    float sign = element & 1 ? 1.0f : -1.0f;
+    switch (element >> 1)
+    {
+        case 0: return vec3(sign, 0.0f, 0.0f);
+        case 1: return vec3(0.0f, sign, 0.0f);
+        default: return vec3(0.0f, 0.0f, sign);
+    }
+}
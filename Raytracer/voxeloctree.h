@@ -0,0 +1,78 @@
+//
+//  voxeloctree.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__voxeloctree__
+#define __Raytracer__voxeloctree__
+
+#include "primitives.h"
+#include <vector>
+
+//integer coordinates of a solid voxel.
+struct Voxel
+{
+    uint16_t x, y, z;
+};
+
+//a sparse voxel octree of solid cubes. Nodes are stored breadth first and refer to their
+//children by index, children of the same node sit next to each other and only exist for
+//the set bits of the node's child mask. The deepest level of nodes has no children at all,
+//its child mask marks which voxels are solid. Rays starting inside a solid voxel pass out of it.
+struct VoxelOctree : Primitive
+{
+    //builds the octree for a resolution^3 grid (resolution must be a power of two from 2 to 65536) with
+    //voxel (0,0,0) starting at origin. Duplicate voxels are ignored. A bad resolution or a voxel outside
+    //the grid is reported on stderr and gives an empty octree.
+    VoxelOctree(vec3 origin, float voxelSize, int resolution, const std::vector<Voxel>& voxels);
+
+    //loads a voxel file written by Save, returning null with an error on stderr if it can't be read,
+    //its voxel count is more than the file holds, or its resolution or voxels are bad.
+    //The format is "SVOX", a uint32 resolution, a uint64 voxel count then that many
+    //Voxels as three little endian uint16s.
+    static VoxelOctree* Load(const char* file, vec3 origin, float voxelSize);
+    static bool Save(const char* file, int resolution, const std::vector<Voxel>& voxels);
+
+    virtual Primitive* Clone() const
+    {
+        return new VoxelOctree(*this);
+    }
+
+    //the element returned is the face that was hit, 0/1 for -x/+x, 2/3 for -y/+y and 4/5 for -z/+z
+    virtual bool Raycast(const Ray& ray, float& intersection, uint64_t& element);
+    virtual vec3 GetNormal(const vec3& pos, uint64_t element);
+
+    virtual bool GetBounds(AABB& bounds)
+    {
+        float size = voxelSize * resolution;
+        bounds = AABB(origin, origin + vec3(size, size, size));
+        return true;
+    }
+
+    //bytes used by the nodes.
+    size_t MemoryUsage() const;
+
+    size_t NodeCount() const
+    {
+        return nodes.size();
+    }
+
+private:
+    struct Node
+    {
+        uint32_t firstChild;//index of the node for the lowest set bit of childMask
+        uint8_t childMask;//bit x | y << 1 | z << 2 is set when that child octant is occupied
+    };
+
+    vec3 origin;
+    float voxelSize;
+    int resolution, depth;
+    std::vector<Node> nodes;
+
+    bool Traverse(uint32_t index, int level, vec3 t0, vec3 t1, int mirror, float& intersection, int& axis) const;
+};
+
+#endif /* defined(__Raytracer__voxeloctree__) */
@@ -0,0 +1,303 @@
+//
+//  wavefront.cpp
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#include "wavefront.h"
+#include "fastmaths.h"
+#include <float.h>
+#include <stdint.h>
+#include <algorithm>
+
+static const uint32_t missed = UINT32_MAX;
+
+//the queue of rays at one depth, plus what each stage works out about them
+struct Bounce
+{
+    std::vector<Ray> rays;
+
+    //filled in by extend, scene index of the nearest primitive or missed
+    std::vector<uint32_t> hitPrimitives;
+    std::vector<float> hitIntersections;
+    std::vector<uint64_t> hitElements;
+
+    //filled in by shade and shadow, kept until the bounces are combined
+    std::vector<vec3> colors, materialColors;
+    std::vector<float> reflects;
+    std::vector<uint32_t> children;//index of the reflection ray in the next bounce or missed
+};
+
+//a ray towards a light and the light it adds to its owner if nothing is in the way
+struct ShadowRay
+{
+    Ray ray;
+    uint32_t owner, light;
+    vec3 diffuse, spec;
+    bool hasDiffuse, hasSpec;
+};
+
+//stable counting sort of items by keys[item], keys are all below keyCount
+static void sortbykey(std::vector<uint32_t>& items, const std::vector<uint32_t>& keys, uint32_t keyCount)
+{
+    std::vector<uint32_t> starts(keyCount + 1, 0);
+    for (uint32_t item : items)
+        starts[keys[item] + 1]++;
+    for (uint32_t i = 0; i<keyCount; i++)
+        starts[i + 1] += starts[i];
+
+    std::vector<uint32_t> sorted(items.size());
+    for (uint32_t item : items)
+        sorted[starts[keys[item]]++] = item;
+    items.swap(sorted);
+}
+
+//direction octant of each ray, so packets get rays heading the same way
+static void sortbydirection(std::vector<uint32_t>& order, const Ray* rays, size_t count)
+{
+    std::vector<uint32_t> octants(count);
+    order.resize(count);
+    for (size_t i = 0; i<count; i++)
+    {
+        const vec3& d = rays[i].direction;
+        octants[i] = (d.x < 0.0f) | (d.y < 0.0f) << 1 | (d.z < 0.0f) << 2;
+        order[i] = (uint32_t)i;
+    }
+    sortbykey(order, octants, 8);
+}
+
+//gathers the rays of order[first...first+8] into a packet, repeating the last ray past the end
+static int gatherpacket(const std::vector<uint32_t>& order, size_t first, const Ray* rays, uint32_t* lanes, RayPacket& packet)
+{
+    int count = (int)std::min(order.size() - first, (size_t)8);
+    Ray packetRays[8];
+    for (int lane = 0; lane<8; lane++)
+    {
+        lanes[lane] = order[first + std::min(lane, count - 1)];
+        packetRays[lane] = rays[lanes[lane]];
+    }
+    packet = RayPacket(packetRays);
+    return count;
+}
+
+//finds the nearest hit of every ray in the bounce, the same way raytrace does
+static void extend(const std::vector<Primitive*>& scene, Bounce& bounce)
+{
+    size_t count = bounce.rays.size();
+    bounce.hitPrimitives.assign(count, missed);
+    bounce.hitIntersections.assign(count, FLT_MAX);
+    bounce.hitElements.assign(count, 0);
+
+    std::vector<uint32_t> order;
+    sortbydirection(order, bounce.rays.data(), count);
+
+    for (size_t i = 0; i<count; i+=8)
+    {
+        uint32_t lanes[8];
+        RayPacket packet;
+        int laneCount = gatherpacket(order, i, bounce.rays.data(), lanes, packet);
+
+        floatx8 nearestIntersection(FLT_MAX), intersection;
+        uint64_t nearestElement[8] = {}, element[8];
+        uint32_t nearestPrimitive[8] = { missed, missed, missed, missed, missed, missed, missed, missed };
+        for (size_t p = 0; p<scene.size(); p++)
+        {
+            maskx8 hits = scene[p]->RaycastPacket(packet, intersection, element);
+            maskx8 closer = hits & (intersection < nearestIntersection);
+            if (closer.none())
+                continue;
+
+            nearestIntersection = floatx8::select(closer, intersection, nearestIntersection);
+            for (int bits = closer.bits(); bits; bits &= bits - 1)
+            {
+                int lane = __builtin_ctz(bits);
+                nearestElement[lane] = element[lane];
+                nearestPrimitive[lane] = (uint32_t)p;
+            }
+        }
+
+        for (int lane = 0; lane<laneCount; lane++)
+        {
+            bounce.hitPrimitives[lanes[lane]] = nearestPrimitive[lane];
+            bounce.hitIntersections[lanes[lane]] = nearestIntersection[lane];
+            bounce.hitElements[lanes[lane]] = nearestElement[lane];
+        }
+    }
+}
+
+//lights the rays that hit something, grouped by the primitive they hit. Each light gets a shadow
+//ray carrying what it would add, reflective hits queue a ray into the next bounce.
+static void shade(const std::vector<Primitive*>& scene, const std::vector<Primitive*>& lights, Bounce& bounce, bool reflect, std::vector<ShadowRay>& shadows, Bounce& next)
+{
+    size_t count = bounce.rays.size();
+    bounce.colors.assign(count, vec3());
+    bounce.materialColors.assign(count, vec3());
+    bounce.reflects.assign(count, 0.0f);
+    bounce.children.assign(count, missed);
+
+    //the misses stay black and drop out here
+    std::vector<uint32_t> hits;
+    for (size_t i = 0; i<count; i++)
+    {
+        if (bounce.hitPrimitives[i] != missed)
+            hits.push_back((uint32_t)i);
+    }
+    sortbykey(hits, bounce.hitPrimitives, (uint32_t)scene.size());
+
+    for (uint32_t i : hits)
+    {
+        const Ray& r = bounce.rays[i];
+        Primitive* primitive = scene[bounce.hitPrimitives[i]];
+        const Material& material = primitive->material;
+        vec3 pos = r.origin + r.direction * bounce.hitIntersections[i];
+        vec3 N = primitive->GetNormal(pos, bounce.hitElements[i]);
+
+        if (primitive->isLight)
+        {
+            bounce.colors[i] = material.color;
+            continue;
+        }
+
+        for (uint32_t l = 0; l<lights.size(); l++)
+        {
+            Primitive* light = lights[l];
+            ShadowRay shadow;
+            vec3 L = shadenormalize(((Sphere*)light)->pos - pos);
+            shadow.ray = Ray(pos + L * 0.01f, L);
+            shadow.owner = i;
+            shadow.light = l;
+
+            //N dot L diffuse lighting
+            shadow.hasDiffuse = material.diffuse > 0.0f;
+            if (shadow.hasDiffuse)
+            {
+                float diffuse = N.dot(L) * material.diffuse;
+                shadow.diffuse = light->material.color * material.color * diffuse;
+            }
+
+            //specular component
+            shadow.hasSpec = false;
+            if (material.spec > 0.0f)
+            {
+                vec3 R = L - N * L.dot(N) * 2.0f;
+                float dot = r.direction.dot(R);
+                shadow.hasSpec = dot > 0.0f;
+                if (shadow.hasSpec)
+                    shadow.spec = light->material.color * material.color * shadepow(dot, material.shininess) * material.spec;
+            }
+
+            shadows.push_back(shadow);
+        }
+
+        if (material.reflect > 0.0f && reflect)
+        {
+            vec3 R = r.direction - N * 2.0f * r.direction.dot(N);
+            bounce.children[i] = (uint32_t)next.rays.size();
+            bounce.materialColors[i] = material.color;
+            bounce.reflects[i] = material.reflect;
+            next.rays.push_back(Ray(pos, R));
+        }
+    }
+}
+
+//tests the shadow rays a light at a time and adds the light of the unblocked ones to their owners
+static void shadow(const std::vector<Primitive*>& scene, const std::vector<Primitive*>& lights, const std::vector<ShadowRay>& shadows, Bounce& bounce)
+{
+    size_t count = shadows.size();
+    std::vector<Ray> rays(count);
+    std::vector<uint32_t> order(count), lightKeys(count);
+    for (size_t i = 0; i<count; i++)
+    {
+        rays[i] = shadows[i].ray;
+        lightKeys[i] = shadows[i].light;
+        order[i] = (uint32_t)i;
+    }
+    sortbykey(order, lightKeys, (uint32_t)lights.size());
+
+    std::vector<bool> occluded(count, false);
+    for (size_t i = 0; i<count; i+=8)
+    {
+        uint32_t lanes[8];
+        RayPacket packet;
+        int laneCount = gatherpacket(order, i, rays.data(), lanes, packet);
+
+        //any hit will do, stop once every lane is blocked
+        floatx8 intersection;
+        uint64_t element[8];
+        int blocked = 0;
+        for (Primitive* p : scene)
+        {
+            if (p->isLight)
+                continue;
+
+            blocked |= p->RaycastPacket(packet, intersection, element).bits();
+            if (blocked == 0xff)
+                break;
+        }
+
+        for (int lane = 0; lane<laneCount; lane++)
+            occluded[lanes[lane]] = (blocked >> lane) & 1;
+    }
+
+    //in the order shade queued them, so each owner adds its lights up in scene order
+    for (size_t i = 0; i<count; i++)
+    {
+        const ShadowRay& s = shadows[i];
+        float shade = occluded[i] ? 0.0f : 1.0f;
+        if (s.hasDiffuse)
+            bounce.colors[s.owner] += s.diffuse * shade;
+        if (s.hasSpec)
+            bounce.colors[s.owner] += s.spec * shade;
+    }
+}
+
+void renderwavefront(const std::vector<Primitive*>& scene, const Camera& camera, int maxDepth, std::vector<vec3>& colors)
+{
+    std::vector<Primitive*> lights;
+    for (Primitive* p : scene)
+    {
+        if (p->isLight)
+            lights.push_back(p);
+    }
+
+    //generate
+    std::vector<Bounce> bounces(1);
+    std::vector<Ray>& primary = bounces[0].rays;
+    primary.resize((size_t)camera.width * camera.height);
+    for (int y = 0; y<camera.height; y++)
+        camera.GetRays(0, y, camera.width, &primary[(size_t)y * camera.width]);
+
+    for (int depth = 0; !bounces[depth].rays.empty(); depth++)
+    {
+        bounces.push_back(Bounce());
+        Bounce& bounce = bounces[depth];
+
+        extend(scene, bounce);
+
+        std::vector<ShadowRay> shadows;
+        shade(scene, lights, bounce, depth < maxDepth, shadows, bounces[depth + 1]);
+        shadow(scene, lights, shadows, bounce);
+
+        //only the colours are needed from here on
+        std::vector<Ray>().swap(bounce.rays);
+        std::vector<uint32_t>().swap(bounce.hitPrimitives);
+        std::vector<float>().swap(bounce.hitIntersections);
+        std::vector<uint64_t>().swap(bounce.hitElements);
+    }
+
+    //add each reflection into the ray it came from, deepest first
+    for (size_t depth = bounces.size() - 1; depth > 0; depth--)
+    {
+        Bounce& bounce = bounces[depth - 1];
+        const std::vector<vec3>& reflectCols = bounces[depth].colors;
+        for (size_t i = 0; i<bounce.children.size(); i++)
+        {
+            if (bounce.children[i] != missed)
+                bounce.colors[i] += reflectCols[bounce.children[i]] * bounce.materialColors[i] * bounce.reflects[i];
+        }
+    }
+
+    colors.swap(bounces[0].colors);
+}
@@ -0,0 +1,28 @@
+//
+//  wavefront.h
+//  Raytracer
+//
+//  Created by Alex Parker on 18/10/2026.
+//  Copyright (c) 2026 Alex Parker. All rights reserved.
+//
+
+#ifndef __Raytracer__wavefront__
+#define __Raytracer__wavefront__
+
+#include "primitives.h"
+#include "camera.h"
+#include <vector>
+
+//Renders the same image as tracing each pixel recursively with raytrace, but moves rays through
+//the work in bulk, one bounce at a time. Each bounce runs these stages over a queue of rays:
+//  extend  - sorts the rays by direction and finds their nearest hits eight at a time
+//  shade   - drops the rays that missed, sorts the hits by primitive and lights them, queueing a
+//            shadow ray per light and a reflection ray for reflective hits
+//  shadow  - sorts the shadow rays by light and tests them eight at a time, then adds each
+//            light's contribution in scene order
+//The reflection rays become the next bounce's queue. Colours are combined back to front once the
+//last bounce is done, in the same order raytrace adds them up, so the results match exactly.
+//The primary rays come from camera, colors is filled in with a colour for each of its pixels.
+void renderwavefront(const std::vector<Primitive*>& scene, const Camera& camera, int maxDepth, std::vector<vec3>& colors);
+
+#endif /* defined(__Raytracer__wavefront__) */